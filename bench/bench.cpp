@@ -0,0 +1,351 @@
+/*
+ * Copyright (C) 2010, 2011, 2012 by Sergey Urbanovich
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QTextCodec>
+#include <QtAlgorithms>
+#include <stdio.h>
+
+#include "utils.h"
+#include "webpage.h"
+#include "serializer.h"
+#include "networkaccessmanager.h"
+#include "networkreplystdinimpl.h"
+
+/* every case runs once to warm up, then REPEAT times, the median is reported */
+#define REPEAT 15
+#define SEED   20121019
+
+
+class Bench
+{
+public:
+	virtual ~Bench() {}
+	virtual void run() = 0;
+};
+
+
+/* fixed seed, so every run measures the same input */
+static quint32 rnd()
+{
+	static quint32 state = SEED;
+	state = state * 1103515245 + 12345;
+	return state >> 8;
+}
+
+
+static QString words( int length, const QString &alphabet )
+{
+	QString text;
+	text.reserve(length);
+	while ( text.length() < length ) {
+		int word = 2 + rnd() % 8;
+		for ( int i = 0; i < word; ++i )
+			text += alphabet.at(rnd() % alphabet.length());
+		text += rnd() % 12 ? ' ' : '\n';
+	}
+	text.truncate(length);
+	return text;
+}
+
+
+static void report( const char *name, const QString &param, qint64 size, Bench &bench )
+{
+	QVector<qint64> times;
+	QElapsedTimer timer;
+
+	bench.run();
+	for ( int i = 0; i < REPEAT; ++i ) {
+		timer.start();
+		bench.run();
+		times << timer.nsecsElapsed();
+	}
+	qSort(times);
+
+	qint64 median = times.at(REPEAT / 2);
+	printf("%-22s %-22s %10lld %14lld %12.3f\n", name, qPrintable(param),
+	       size, median, (double) median / qMax(size, (qint64) 1));
+	fflush(stdout);
+}
+
+
+/* detectEncoding */
+
+class EncodingBench : public Bench
+{
+public:
+	EncodingBench( const QByteArray &content ) : content(content) {}
+	void run() { detectEncoding(content); }
+private:
+	QByteArray content;
+};
+
+
+static void benchEncoding()
+{
+	const char *charsets[][2] = {
+		{ "UTF-8",        "abcdefghijklmnopqrstuvwxyz\xd0\xb0\xd0\xb1\xd0\xb2\xd0\xb3\xd0\xb4\xd0\xb5" },
+		{ "windows-1251", "\xd0\xb0\xd0\xb1\xd0\xb2\xd0\xb3\xd0\xb4\xd0\xb5\xd0\xb6\xd0\xb7\xd0\xb8\xd0\xba\xd0\xbb\xd0\xbc" },
+		{ "ISO-8859-1",   "abcdefghijklmnopqrstuvwxyz\xc3\xa4\xc3\xb6\xc3\xbc\xc3\x9f\xc3\xa9" },
+		{ "Shift_JIS",    "\xe3\x81\x82\xe3\x81\x84\xe3\x81\x86\xe3\x81\x88\xe3\x81\x8a\xe6\x97\xa5\xe6\x9c\xac" },
+	};
+	int sizes[] = { 1024, 16 * 1024, 256 * 1024 };
+
+	for ( unsigned i = 0; i < sizeof(charsets) / sizeof(charsets[0]); ++i ) {
+		QTextCodec *codec = QTextCodec::codecForName(charsets[i][0]);
+		QString alphabet = QString::fromUtf8(charsets[i][1]);
+		for ( unsigned j = 0; j < sizeof(sizes) / sizeof(sizes[0]); ++j ) {
+			QByteArray content = codec->fromUnicode(words(sizes[j], alphabet));
+			EncodingBench bench(content);
+			report("detectEncoding", charsets[i][0], content.size(), bench);
+		}
+	}
+}
+
+
+/* NetworkReplyStdinImpl::readData */
+
+class ReadBench : public Bench
+{
+public:
+	ReadBench( const QByteArray &content, int chunk ) : content(content), chunk(chunk) {}
+	void run()
+	{
+		QString mime("text/html");
+		QNetworkRequest request(QUrl("stdin://localhost/"));
+		NetworkReplyStdinImpl reply(NULL, QNetworkAccessManager::GetOperation, request, content, mime);
+		QByteArray buffer(chunk, 0);
+		while ( reply.read(buffer.data(), chunk) > 0 )
+			;
+	}
+private:
+	QByteArray content;
+	int chunk;
+};
+
+
+static void benchRead()
+{
+	QByteArray content = words(4 * 1024 * 1024, "abcdefghijklmnopqrstuvwxyz").toUtf8();
+	int chunks[] = { 512, 4096, 65536, content.size() };
+	for ( unsigned i = 0; i < sizeof(chunks) / sizeof(chunks[0]); ++i ) {
+		ReadBench bench(content, chunks[i]);
+		report("readData", QString("chunk %1").arg(chunks[i]), content.size(), bench);
+	}
+}
+
+
+/* NetworkAccessManager::createRequest allow decision */
+
+class AllowBench : public Bench
+{
+public:
+	AllowBench( NetworkAccessManager *manager, const QList<QUrl> &urls ) : manager(manager), urls(urls) {}
+	void run()
+	{
+		foreach (const QUrl &url, urls)
+			manager->allowRequest(url);
+	}
+private:
+	NetworkAccessManager *manager;
+	QList<QUrl> urls;
+};
+
+
+static void benchAllow()
+{
+	int redirects[] = { 0, 100, 1000, 10000 };
+	QList<QUrl> urls;
+	for ( int i = 0; i < 1000; ++i )
+		urls << QUrl(QString("http://example.com/page/%1.html").arg(rnd()));
+
+	for ( unsigned i = 0; i < sizeof(redirects) / sizeof(redirects[0]); ++i ) {
+		/* no url matches, every decision scans the whole redirect list */
+		NetworkAccessManager manager(QUrl("http://example.com/"), AA_REDIRECT | AA_CSS | AA_JS);
+		for ( int j = 0; j < redirects[i]; ++j )
+			manager.addRedirect(QUrl(QString("http://example.com/redirect/%1").arg(j)));
+		AllowBench bench(&manager, urls);
+		report("allowRequest x1000", QString("redirects %1").arg(redirects[i]),
+		       qMax(redirects[i], 1), bench);
+	}
+}
+
+
+/* JSTEXT: markers and toPlainText */
+
+class LoadWaiter : public QObject
+{
+	Q_OBJECT
+public:
+	LoadWaiter( QWebPage *page ) : loaded(false)
+	{
+		connect(page, SIGNAL(loadFinished(bool)), SLOT(onLoadFinished()));
+	}
+	void wait()
+	{
+		while ( !loaded )
+			QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+	}
+public slots:
+	void onLoadFinished() { loaded = true; }
+private:
+	bool loaded;
+};
+
+
+/* what --text-only applies, see Application::exec and createPage */
+enum TextMode {
+	TM_LOAD     = 0,  /* setHtml alone, the baseline to subtract */
+	TM_TEXT     = 1,  /* plainText after the load */
+	TM_SETTINGS = 2,  /* WebPage::setTextOnly */
+	TM_VIEWPORT = 4,  /* WebPage::setViewport */
+	TM_FONT     = 8   /* every generic family mapped to one missing font */
+};
+
+
+class TextBench : public Bench
+{
+public:
+	TextBench( const QString &html, int mode, const QSize &viewport = TEXT_ONLY_VIEWPORT )
+		: html(html), mode(mode), viewport(viewport) {}
+	void run()
+	{
+		QWebPage page;
+		LoadWaiter waiter(&page);
+		if ( mode & TM_SETTINGS )
+			WebPage::setTextOnly(page.settings());
+		if ( mode & TM_VIEWPORT )
+			WebPage::setViewport(&page, viewport);
+		if ( mode & TM_FONT ) {
+			QWebSettings::FontFamily families[] = {
+				QWebSettings::StandardFont, QWebSettings::FixedFont, QWebSettings::SerifFont,
+				QWebSettings::SansSerifFont, QWebSettings::CursiveFont, QWebSettings::FantasyFont
+			};
+			for ( unsigned i = 0; i < sizeof(families) / sizeof(families[0]); ++i )
+				page.settings()->setFontFamily(families[i], "sketch");
+		}
+		page.mainFrame()->setHtml(html);
+		waiter.wait();
+		if ( mode & TM_TEXT )
+			WebPage::plainText(page.mainFrame());
+	}
+private:
+	QString html;
+	int mode;
+	QSize viewport;
+};
+
+
+static void benchText()
+{
+	int sizes[] = { 100, 1000, 10000 };
+	for ( unsigned i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i ) {
+		QString html("<html><body>");
+		for ( int j = 0; j < sizes[i]; ++j ) {
+			html += QString("<div><h2>%1</h2><p>%2 <a href=\"/%3\">%1</a></p><ul><li>%1</li></ul></div>")
+				.arg(words(20, "abcdefgh")).arg(words(200, "abcdefghijklmnop")).arg(rnd());
+		}
+		html += "</body></html>";
+
+		/* --text-only is the fourth case, the others pick its parts */
+		QString param = QString("blocks %1").arg(sizes[i]);
+		TextBench load(html, TM_LOAD), text(html, TM_TEXT),
+			settings(html, TM_TEXT | TM_SETTINGS),
+			text_only(html, TM_TEXT | TM_SETTINGS | TM_VIEWPORT),
+			small(html, TM_TEXT | TM_SETTINGS | TM_VIEWPORT, QSize(320, 240)),
+			font(html, TM_TEXT | TM_SETTINGS | TM_VIEWPORT | TM_FONT);
+		report("setHtml", param, html.size(), load);
+		report("setHtml+plainText", param, html.size(), text);
+		report("text-only settings", param, html.size(), settings);
+		report("--text-only", param, html.size(), text_only);
+		report("--text-only 320x240", param, html.size(), small);
+		report("--text-only +font", param, html.size(), font);
+	}
+}
+
+
+/* JSVALUE serialization */
+
+class SerializeBench : public Bench
+{
+public:
+	SerializeBench( const QVariant &value, ValueFormat format ) : value(value), format(format) {}
+	void run()
+	{
+		QByteArray out;
+		serialize(value, format, out);
+	}
+private:
+	QVariant value;
+	ValueFormat format;
+};
+
+
+static void benchSerialize()
+{
+	int sizes[] = { 100, 1000, 10000 };
+	const char *names[] = { "json", "cbor", "msgpack" };
+	for ( unsigned i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i ) {
+		/* what evaluateJavaScript returns for an array of records */
+		QVariantList records;
+		for ( int j = 0; j < sizes[i]; ++j ) {
+			QVariantMap record;
+			record.insert("id", (double) j);
+			record.insert("title", words(40, "abcdefghijklmnop\"\\\n"));
+			record.insert("score", rnd() / 1000.0);
+			record.insert("tags", QStringList() << words(8, "abc") << words(8, "xyz"));
+			records << record;
+		}
+
+		for ( int format = VF_JSON; format <= VF_MSGPACK; ++format ) {
+			QByteArray out;
+			serialize(records, (ValueFormat) format, out);
+			SerializeBench bench(records, (ValueFormat) format);
+			report("serialize", QString("%1 records %2").arg(names[format]).arg(sizes[i]), out.size(), bench);
+		}
+	}
+}
+
+
+int main( int argc, char *argv[] )
+{
+#ifdef Q_WS_QPA
+	setenv("QT_QPA_PLATFORM", "minimal", 0);
+#endif /* Q_WS_QPA */
+
+	QApplication::setGraphicsSystem("raster");
+	QApplication app(argc, argv);
+	QWebSettings::globalSettings()->setAttribute(QWebSettings::AutoLoadImages, false);
+
+	/* size is bytes of input, or of output for serialize, or redirects for allowRequest */
+	printf("%-22s %-22s %10s %14s %12s\n", "case", "parameter", "size", "median ns", "ns/unit");
+	benchEncoding();
+	benchRead();
+	benchAllow();
+	benchText();
+	benchSerialize();
+	return EXIT_SUCCESS;
+}
+
+#include "bench.moc"
@@ -0,0 +1,11 @@
+# Microbenchmarks of the native hot paths:
+#   cd bench && qmake && make && ./sketch-bench
+
+QT      += webkit network
+TARGET   = sketch-bench
+include(../src/src.pri)
+SOURCES += bench.cpp
+
+# objects stay next to this file, not in the top directory of sketch
+MOC_DIR = $$PWD
+OBJECTS_DIR = $$PWD
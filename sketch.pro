@@ -1,15 +1,8 @@
 QT      += webkit network
+include(src/src.pri)
 VPATH   += src
-HEADERS  = utils.h \
-           webpage.h \
-           application.h \
-           networkaccessmanager.h \
-           networkreplystdinimpl.h
-SOURCES  = utils.cpp \
-           webpage.cpp \
-           application.cpp \
-           networkaccessmanager.cpp \
-           networkreplystdinimpl.cpp \
+HEADERS += application.h
+SOURCES += application.cpp \
            main.cpp
 
 RESOURCES += res/main.qrc
@@ -17,13 +10,3 @@ RESOURCES += res/main.qrc
 MOC_DIR = src
 OBJECTS_DIR = src
 RCC_DIR = res
-
-unix {
-    QMAKE_CXXFLAGS += $$system(icu-config --cppflags)
-    LIBS += $$system(icu-config --ldflags)
-}
-
-x11 {
-    CONFIG    += link_pkgconfig
-    PKGCONFIG += fontconfig
-}
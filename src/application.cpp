@@ -26,11 +26,15 @@
 #include "networkaccessmanager.h"
 #include "application.h"
 #include "utils.h"
-
-#include "unicode/utypes.h"
-#include "unicode/ucsdet.h"
+#include "trace.h"
 
 #define STDIN_URL "stdin://localhost/"
+/* charset detection of compressed content looks at the decompressed prefix */
+#define DETECT_PREFIX (64 * 1024)
+#define CRAWL_DEPTH       2
+#define CRAWL_DELAY       1000 /* ms between requests to a host */
+#define CRAWL_CONCURRENCY 4
+#define DEDUP_DISTANCE    3 /* bits of 64 */
 
 
 static QString read_file( QString filename )
@@ -73,6 +77,40 @@ static PJsGoal takeArgJs( QString arg, QStringList &args, bool ffile = false )
 	return PJsGoal( ( ffile ? read_file(js) : js ), jsgoal);
 }
 
+static int takeArgInt( QStringList &args, int min )
+{
+	bool ok = false;
+	int value = args.isEmpty() ? 0 : args.takeFirst().toInt(&ok);
+	if ( !ok || value < min ) {
+		usage();
+	}
+	return value;
+}
+
+
+/* all --select options make up a single goal, one record */
+static void takeArgSelect( QString arg, QStringList &args, QList<PJsGoal> &js )
+{
+	QString field = arg.isNull() ? "text" : arg;
+	if ( field.startsWith("attr-") )
+		field = "@" + field.mid(5);
+	if ( (field != "text" && field != "html" && !field.startsWith("@")) ||
+	     field == "@" || args.isEmpty() ) {
+		usage();
+	}
+	/* newlines separate fields in the goal, quoted whitespace stays as given */
+	QString selector = args.takeFirst().replace('\n', ' ').replace('\r', ' ').trimmed();
+	QString select = field + " " + selector;
+
+	for ( int i = 0; i < js.size(); ++i ) {
+		if ( js[i].second == JSSELECT ) {
+			js[i].first += "\n" + select;
+			return;
+		}
+	}
+	js << PJsGoal(select, JSSELECT);
+}
+
 template <class T>
 static QString takeArg( T arg, QStringList &args )
 {
@@ -84,7 +122,13 @@ static QString takeArg( T arg, QStringList &args )
 
 
 Application::Application( int argc, char *argv[] )
-	: QApplication(argc, argv), enable_js(false), allow(AA_NONE)
+	: QApplication(argc, argv), enable_js(false), text_only(false),
+	  allow(AA_NONE), value_format(VF_JSON),
+	  text_clean(TC_NONE), input_compression(CM_AUTO), shard(0), shards(1),
+	  crawl_depth(CRAWL_DEPTH), crawl_delay(CRAWL_DELAY), crawl_concurrency(CRAWL_CONCURRENCY),
+	  dedup_window(0), dedup_distance(DEDUP_DISTANCE), dedup_flag(false), page(NULL),
+	  networkAccessManager(NULL), warc(NULL), archive(NULL), crawler(NULL),
+	  deduplicator(NULL), failures(0)
 {
 	QUrl baseurl;
 	QStringList args = arguments();
@@ -100,6 +144,8 @@ Application::Application( int argc, char *argv[] )
 			mime = takeArg(mime, args);
 		} else if ( arg == "--enable-js" ) {
 			enable_js = true;
+		} else if ( arg == "--text-only" ) {
+			text_only = true;
 		} else if ( arg == "--allow-none" ) {
 			allow = AA_NONE;
 		} else if ( arg == "--allow-js" ) {
@@ -116,10 +162,63 @@ Application::Application( int argc, char *argv[] )
 			js << takeArgJs(arg.mid(5), args);
 		} else if ( arg == "--readability" ) {
 			js << PJsGoal(read_file(":/readability.js"), JSTEXT);
+		} else if ( arg == "--select" || arg.startsWith("--select-") ) {
+			takeArgSelect(arg.mid(9), args, js);
+		} else if ( arg == "--metadata" ) {
+			js << PJsGoal(QString(), JSMETA);
 		} else if ( arg == "--print-to-pdf" ) {
 			js << PJsGoal(takeArg(QString(), args), JSPRINT);
 		} else if ( arg == "--readability-html" ) {
 			js << PJsGoal(read_file(":/readability.js"), JSHTML);
+		} else if ( arg == "--value-format" ) {
+			if ( (value_format = valueFormat(takeArg(QString(), args))) == VF_UNDEF )
+				usage();
+		} else if ( arg == "--clean-text" ) {
+			text_clean |= TC_CLEAN;
+		} else if ( arg == "--nfc" ) {
+			text_clean |= TC_CLEAN | TC_NFC;
+		} else if ( arg == "--compression" ) {
+			if ( (input_compression = compression(takeArg(QString(), args))) == CM_UNDEF )
+				usage();
+		} else if ( arg == "--record" ) {
+			record_file = takeArg(record_file, args);
+		} else if ( arg == "--replay" ) {
+			replay_file = takeArg(replay_file, args);
+		} else if ( arg == "--crawl" ) {
+			crawl << takeArg(QString(), args);
+		} else if ( arg == "--crawl-prefix" ) {
+			crawl_prefixes << takeArg(QString(), args);
+		} else if ( arg == "--crawl-depth" ) {
+			crawl_depth = takeArgInt(args, 0);
+		} else if ( arg == "--crawl-delay" ) {
+			crawl_delay = takeArgInt(args, 0);
+		} else if ( arg == "--crawl-concurrency" ) {
+			crawl_concurrency = takeArgInt(args, 1);
+		} else if ( arg == "--dedup" ) {
+			dedup_window = takeArgInt(args, 1);
+		} else if ( arg == "--dedup-distance" ) {
+			dedup_distance = takeArgInt(args, 0);
+			if ( dedup_distance > DEDUP_MAX_DISTANCE )
+				usage();
+		} else if ( arg == "--dedup-mode" ) {
+			QString mode = takeArg(QString(), args);
+			if ( mode != "drop" && mode != "flag" )
+				usage();
+			dedup_flag = mode == "flag";
+		} else if ( arg == "--warc" ) {
+			warc_file = takeArg(warc_file, args);
+		} else if ( arg == "--warc-index" ) {
+			warc_index = takeArg(warc_index, args);
+		} else if ( arg == "--shard" ) {
+			/* K/N: K-th of N slices, from zero */
+			QStringList shard_arg = takeArg(QString(), args).split('/');
+			bool ok_shard, ok_shards;
+			shard = shard_arg.value(0).toInt(&ok_shard);
+			shards = shard_arg.value(1).toInt(&ok_shards);
+			if ( !ok_shard || !ok_shards || shard < 0 || shard >= shards )
+				usage();
+		} else if ( arg == "--trace" ) {
+			takeArg(QString(), args); /* see traceInitialize */
 		} else if ( arg == "--help" ) {
 			usage(stdout);
 		} else {
@@ -131,11 +230,23 @@ Application::Application( int argc, char *argv[] )
 		usage();
 	}
 
+	if ( !warc_file.isEmpty() && (!baseurl.isEmpty() || !url.isEmpty()) ) {
+		usage();
+	}
+
+	if ( !record_file.isEmpty() && !replay_file.isEmpty() ) {
+		usage();
+	}
+
+	if ( !crawl.isEmpty() && (!url.isEmpty() || !baseurl.isEmpty() || !warc_file.isEmpty()) ) {
+		usage();
+	}
+
 	if ( js.isEmpty() ) {
 		js << PJsGoal(read_file(":/readability.js"), JSTEXT);
 	}
 
-	if ( (from_stdin = url.isEmpty()) ) {
+	if ( (from_stdin = url.isEmpty() && warc_file.isEmpty() && crawl.isEmpty()) ) {
 		url = baseurl;
 	}
 
@@ -155,83 +266,179 @@ int Application::exec()
 	global->setAttribute(QWebSettings::PrivateBrowsingEnabled, true);
 	global->setAttribute(QWebSettings::AutoLoadImages, false);
 
-	page = new WebPage(js);
-	networkAccessManager = new NetworkAccessManager(url, allow);
-	page->setNetworkAccessManager(networkAccessManager);
+	if ( text_only )
+		WebPage::setTextOnly(global);
+
+	if ( !replay_file.isEmpty() ) {
+		archive = new NetworkArchive(replay_file);
+		if ( !archive->load() )
+			return EXIT_FAILURE;
+	} else if ( !record_file.isEmpty() ) {
+		archive = new NetworkArchive(record_file);
+	}
+
+	if ( dedup_window )
+		deduplicator = new Deduplicator(dedup_window, dedup_distance);
+
+	if ( !crawl.isEmpty() ) {
+		QList<WebPage *> pages;
+		for ( int i = 0; i < crawl_concurrency; ++i )
+			pages << createPage();
+		crawler = new Crawler(pages, crawl_depth, crawl_delay, crawl_prefixes);
+		connect(crawler, SIGNAL(finished(int)), SLOT(onCrawlFinished(int)));
+		foreach (const QUrl &seed, crawl)
+			crawler->add(seed);
+		crawler->start();
+		return QCoreApplication::exec();
+	}
+
+	page = createPage();
+	networkAccessManager = (NetworkAccessManager *) page->networkAccessManager();
+
+	/* queued: results are flushed and loadFinished is left before the next document */
+	connect(page, SIGNAL(done(bool)), SLOT(onDone(bool)), Qt::QueuedConnection);
+
+	if ( !warc_file.isEmpty() ) {
+		if ( !openWarc() )
+			return EXIT_FAILURE;
+		loadRecord();
+		return QCoreApplication::exec();
+	}
 
 	if ( from_stdin ) {
+		TraceSpan readSpan("readStdin");
 		QFile in;
 		in.open(stdin, QIODevice::ReadOnly);
 		QByteArray content = in.readAll();
-		networkAccessManager->setContent(content, mime);
-		QString encoding = detectEncoding(content);
-		if ( !encoding.isEmpty() )
-			global->setDefaultTextEncoding(encoding);
+		readSpan.setArg("bytes", content.size());
+		readSpan.end();
+		Compression content_compression = input_compression;
+		if ( content_compression == CM_AUTO )
+			content_compression = detectCompression(content);
+		networkAccessManager->setContent(content, mime, content_compression);
+		setEncoding(content, content_compression);
 	}
-	page->mainFrame()->setUrl(url);
+	page->load(url);
 	return QCoreApplication::exec();
 }
 
 Application::~Application()
 {
+	delete crawler;
 	delete page;
-	delete networkAccessManager;
-}
-
-QString Application::detectEncoding( QByteArray& content )
-{
-#if defined (Q_OS_UNIX)
-	const UCharsetMatch **csm;
-	const char *encoding;
-	int32_t matchCount = 0;
-	UErrorCode status = U_ZERO_ERROR;
-
-	UCharsetDetector *csd = ucsdet_open(&status);
-
-	ucsdet_setText(csd, content.constData(), content.size(), &status);
-	if ( U_FAILURE(status) )
-		goto fail;
-
-	csm = ucsdet_detectAll(csd, &matchCount, &status);
-	if ( U_FAILURE(status) || matchCount == 0 )
-		goto fail;
-
-	encoding = ucsdet_getName(csm[0], &status);
-	if ( U_FAILURE(status) )
-		goto fail;
-
-	if ( matchCount > 1 ) {
-		int max_confidence = ucsdet_getConfidence(csm[0], &status);
-		if ( U_FAILURE(status) )
-			goto fail;
-		for ( int count = 0; count < matchCount; ++count ) {
-			int confidence = ucsdet_getConfidence(csm[count], &status);
-			if ( U_FAILURE(status) )
-				goto fail;
-			if ( confidence < 0.9 * max_confidence )
-				break;
-			const char *lang = ucsdet_getLanguage(csm[count], &status);
-			if ( U_FAILURE(status) )
-				goto fail;
-			if ( (lang[0] == 'e' && lang[1] == 'n') || /* english    */
-			     (lang[0] == 'e' && lang[1] == 's') || /* spanish    */
-			     (lang[0] == 'p' && lang[1] == 't') || /* portuguese */
-			     (lang[0] == 'd' && lang[1] == 'e') || /* german     */
-			     (lang[0] == 'f' && lang[1] == 'r') || /* french     */
-			     (lang[0] == 'i' && lang[1] == 't')    /* italian    */
-			) {
-				encoding = ucsdet_getName(csm[count], &status);
-				if ( U_FAILURE(status) )
-					goto fail;
-			}
+	delete warc;
+	delete archive;
+	delete deduplicator;
+}
+
+WebPage *Application::createPage()
+{
+	WebPage *page = new WebPage(js, value_format, text_clean);
+	NetworkAccessManager *manager = new NetworkAccessManager(url, text_only ? allow | AA_NOFONT : allow);
+	manager->setParent(page);
+	if ( archive )
+		manager->setArchive(archive, !replay_file.isEmpty());
+	page->setNetworkAccessManager(manager);
+	if ( text_only )
+		WebPage::setViewport(page, TEXT_ONLY_VIEWPORT);
+	if ( deduplicator )
+		page->setDeduplicator(deduplicator, dedup_flag);
+	return page;
+}
+
+void Application::onCrawlFinished( int crawl_failures )
+{
+	failures += crawl_failures;
+	finish();
+}
+
+void Application::onDone( bool success )
+{
+	if ( !success )
+		failures++;
+
+	if ( warc )
+		loadRecord();
+	else
+		finish();
+}
+
+void Application::finish()
+{
+	int status = failures ? EXIT_FAILURE : EXIT_SUCCESS;
+	QApplication::exit(status);
+	exit(status);
+}
+
+bool Application::openWarc()
+{
+	warc = new WarcReader(warc_file);
+	if ( !warc->open() )
+		return false;
+
+	if ( warc_index.isEmpty() || !warc->loadIndex(warc_index, records) ) {
+		TraceSpan span("warcIndex");
+		if ( !warc->scan(records) )
+			return false;
+		if ( !warc_index.isEmpty() )
+			WarcReader::saveIndex(warc_index, records);
+	}
+
+	/* workers take disjoint contiguous slices of the same index */
+	int from = (qint64) records.size() * shard / shards;
+	int to = (qint64) records.size() * (shard + 1) / shards;
+	records = records.mid(from, to - from);
+	return true;
+}
+
+void Application::loadRecord()
+{
+	while ( !records.isEmpty() ) {
+		WarcEntry entry = records.takeFirst();
+		WarcRecord record;
+
+		TraceSpan span("warcRecord");
+		if ( !warc->read(entry, record) ) {
+			qWarning() << "Couldn't read WARC record" << entry.id;
+			failures++;
+			continue;
 		}
+		/* redirects, errors and "not modified" have no document */
+		if ( record.status < 200 || record.status >= 300 )
+			continue;
+		span.setArg("id", record.id);
+		span.setArg("bytes", record.body.size());
+		span.end();
+
+		QUrl record_url = record.uri;
+		if ( record_url.path().isEmpty() )
+			record_url.setPath("/");
+		if ( record.mime.isEmpty() )
+			record.mime = mime;
+
+		networkAccessManager->setBaseUrl(record_url);
+		networkAccessManager->setContent(record.body, record.mime, record.compression);
+		setEncoding(record.body, record.compression);
+		page->load(record_url, record.id);
+		return;
 	}
 
-	ucsdet_close(csd);
-	return encoding;
+	finish();
+}
+
+void Application::setEncoding( QByteArray &content, Compression compression )
+{
+	TraceSpan span("detectEncoding");
+	QString encoding;
+	if ( compression == CM_NONE ) {
+		encoding = detectEncoding(content);
+	} else {
+		QByteArray prefix = Decompressor::prefix(compression, content, DETECT_PREFIX);
+		encoding = detectEncoding(prefix);
+	}
+	span.setArg("encoding", encoding);
+	span.end();
 
-fail:
-	ucsdet_close(csd);
-#endif
-	return "";
+	/* an empty encoding resets the previous record's charset in batch mode */
+	QWebSettings::globalSettings()->setDefaultTextEncoding(encoding);
 }
@@ -28,6 +28,8 @@
 #include <QApplication>
 #include "webpage.h"
 #include "networkaccessmanager.h"
+#include "warcreader.h"
+#include "crawler.h"
 
 class Application: public QApplication
 {
@@ -43,12 +45,45 @@ public:
 	QList<PJsGoal> js;
 	bool from_stdin;
 	bool enable_js;
+	bool text_only;
 	int allow;
+	ValueFormat value_format;
+	int text_clean;
+	Compression input_compression;
+	QString record_file;
+	QString replay_file;
+	QString warc_file;
+	QString warc_index;
+	int shard;
+	int shards;
+	QList<QUrl> crawl;
+	QStringList crawl_prefixes;
+	int crawl_depth;
+	int crawl_delay;
+	int crawl_concurrency;
+	int dedup_window;
+	int dedup_distance;
+	bool dedup_flag;
+
+private slots:
+	void onDone( bool success );
+	void loadRecord();
+	void onCrawlFinished( int crawl_failures );
+
 private:
 	WebPage *page;
 	NetworkAccessManager *networkAccessManager;
+	WarcReader *warc;
+	NetworkArchive *archive;
+	Crawler *crawler;
+	Deduplicator *deduplicator;
+	QList<WarcEntry> records;
+	int failures;
 
-	QString detectEncoding( QByteArray& content );
+	WebPage *createPage();
+	bool openWarc();
+	void finish();
+	void setEncoding( QByteArray &content, Compression compression );
 };
 
 
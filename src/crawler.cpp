@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2010, 2011, 2012 by Sergey Urbanovich
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include "crawler.h"
+#include "networkaccessmanager.h"
+
+
+Crawler::Crawler( const QList<WebPage *> &pages, int depth, int delay, const QStringList &prefixes )
+	: pages(pages), idle(pages), prefixes(prefixes), max_depth(depth), delay(delay), failures(0)
+{
+	timer.setSingleShot(true);
+	connect(&timer, SIGNAL(timeout()), SLOT(schedule()));
+	/* queued: results are flushed and loadFinished is left before the next url */
+	foreach (WebPage *page, pages) {
+		page->setCollectLinks(true);
+		connect(page, SIGNAL(done(bool)), SLOT(onDone(bool)), Qt::QueuedConnection);
+	}
+}
+
+
+Crawler::~Crawler()
+{
+	qDeleteAll(pages);
+}
+
+
+/* without prefixes the crawl stays on the hosts of the seeds */
+bool Crawler::accept( const QUrl &url ) const
+{
+	if ( prefixes.isEmpty() )
+		return hosts.contains(url.host().toLower());
+
+	QString str = url.toString();
+	foreach (const QString &prefix, prefixes)
+		if ( str.startsWith(prefix) )
+			return true;
+	return false;
+}
+
+
+void Crawler::add( QUrl url, int depth )
+{
+	url.setFragment(QString());
+	if ( url.path().isEmpty() )
+		url.setPath("/");
+
+	QString host = url.host().toLower();
+	if ( depth == 0 )
+		hosts.insert(host);
+	else if ( !accept(url) )
+		return;
+
+	QByteArray key = url.toEncoded();
+	if ( seen.contains(key) )
+		return;
+	seen.insert(key);
+	frontier[host] << CrawlEntry(url, depth);
+}
+
+
+void Crawler::start()
+{
+	clock.start();
+	schedule();
+}
+
+
+void Crawler::schedule()
+{
+	qint64 now = clock.elapsed(), wait = -1;
+
+	QMap<QString, QList<CrawlEntry> >::iterator it = frontier.begin();
+	while ( !idle.isEmpty() && it != frontier.end() ) {
+		qint64 ready = next_start.value(it.key(), 0);
+		if ( ready > now ) {
+			if ( wait < 0 || ready - now < wait )
+				wait = ready - now;
+			++it;
+			continue;
+		}
+
+		/* without a delay the same host is drained while idle pages remain */
+		CrawlEntry entry = it.value().takeFirst();
+		if ( delay > 0 )
+			next_start.insert(it.key(), now + delay);
+		if ( it.value().isEmpty() ) {
+			it = frontier.erase(it);
+		} else if ( delay > 0 ) {
+			if ( wait < 0 || delay < wait )
+				wait = delay;
+			++it;
+		}
+
+		WebPage *page = idle.takeFirst();
+		depths.insert(page, entry.second);
+		((NetworkAccessManager *) page->networkAccessManager())->setBaseUrl(entry.first);
+		page->load(entry.first, entry.first.toString());
+	}
+
+	if ( wait >= 0 && !idle.isEmpty() )
+		timer.start(wait);
+	else if ( frontier.isEmpty() && idle.size() == pages.size() )
+		emit finished(failures);
+}
+
+
+void Crawler::onDone( bool success )
+{
+	WebPage *page = (WebPage *) sender();
+	int depth = depths.take(page);
+
+	if ( !success ) {
+		failures++;
+	} else if ( depth < max_depth ) {
+		foreach (const QString &link, page->links())
+			add(QUrl(link), depth + 1);
+	}
+
+	idle << page;
+	schedule();
+}
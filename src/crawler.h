@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2010, 2011, 2012 by Sergey Urbanovich
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef CRAWLER_H
+#define CRAWLER_H
+
+
+#include <QtWebKit>
+#include "webpage.h"
+
+typedef QPair<QUrl, int> CrawlEntry;
+
+/*
+ * Same-site crawl, see --crawl. Every page is a worker: it loads a url,
+ * runs the goals and hands its links back to the frontier. Requests to
+ * one host are started at least "delay" ms apart.
+ */
+class Crawler : public QObject
+{
+	Q_OBJECT
+	public:
+		Crawler( const QList<WebPage *> &pages, int depth, int delay, const QStringList &prefixes );
+		~Crawler();
+		void add( QUrl url, int depth = 0 );
+		void start();
+
+	signals:
+		void finished( int failures );
+
+	private slots:
+		void schedule();
+		void onDone( bool success );
+
+	private:
+		bool accept( const QUrl &url ) const;
+
+		QList<WebPage *> pages;
+		QList<WebPage *> idle;
+		QHash<WebPage *, int> depths;
+		QMap<QString, QList<CrawlEntry> > frontier;
+		QHash<QString, qint64> next_start;
+		QSet<QByteArray> seen;
+		QSet<QString> hosts;
+		QStringList prefixes;
+		QElapsedTimer clock;
+		QTimer timer;
+		int max_depth;
+		int delay;
+		int failures;
+};
+
+
+#endif /* CRAWLER_H */
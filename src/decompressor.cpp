@@ -0,0 +1,227 @@
+/*
+ * Copyright (C) 2010, 2011, 2012 by Sergey Urbanovich
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <zlib.h>
+#include <zstd.h>
+#include <brotli/decode.h>
+#include <limits.h>
+
+#include "decompressor.h"
+
+
+struct DecompressorPrivate
+{
+	z_stream zstream;
+	ZSTD_DStream *zstd;
+	BrotliDecoderState *brotli;
+};
+
+
+Compression compression( const QString &name )
+{
+	if ( name == "auto" )
+		return CM_AUTO;
+	else if ( name == "none" )
+		return CM_NONE;
+	else if ( name == "gzip" )
+		return CM_GZIP;
+	else if ( name == "zstd" )
+		return CM_ZSTD;
+	else if ( name == "brotli" )
+		return CM_BROTLI;
+	return CM_UNDEF;
+}
+
+
+Compression detectCompression( const QByteArray &content )
+{
+	const unsigned char *magic = (const unsigned char *) content.constData();
+	if ( content.size() >= 2 && magic[0] == 0x1f && magic[1] == 0x8b )
+		return CM_GZIP;
+	if ( content.size() >= 4 && magic[0] == 0x28 && magic[1] == 0xb5 &&
+	     magic[2] == 0x2f && magic[3] == 0xfd )
+		return CM_ZSTD;
+	return CM_NONE;
+}
+
+
+Decompressor::Decompressor( Compression type ) : type(type), end(false)
+{
+	d = new DecompressorPrivate();
+	switch ( type ) {
+		case CM_GZIP:
+			/* 15 + 32: maximum window, zlib or gzip header */
+			inflateInit2(&d->zstream, 15 + 32);
+			break;
+		case CM_ZSTD:
+			d->zstd = ZSTD_createDStream();
+			ZSTD_initDStream(d->zstd);
+			break;
+		case CM_BROTLI:
+			d->brotli = BrotliDecoderCreateInstance(NULL, NULL, NULL);
+			break;
+		default:
+			break;
+	}
+}
+
+
+Decompressor::~Decompressor()
+{
+	switch ( type ) {
+		case CM_GZIP:
+			inflateEnd(&d->zstream);
+			break;
+		case CM_ZSTD:
+			ZSTD_freeDStream(d->zstd);
+			break;
+		case CM_BROTLI:
+			BrotliDecoderDestroyInstance(d->brotli);
+			break;
+		default:
+			break;
+	}
+	delete d;
+}
+
+
+bool Decompressor::atEnd() const
+{
+	return end;
+}
+
+
+void Decompressor::reset()
+{
+	end = false;
+	switch ( type ) {
+		case CM_GZIP:
+			inflateReset(&d->zstream);
+			break;
+		case CM_ZSTD:
+			ZSTD_initDStream(d->zstd);
+			break;
+		case CM_BROTLI:
+			BrotliDecoderDestroyInstance(d->brotli);
+			d->brotli = BrotliDecoderCreateInstance(NULL, NULL, NULL);
+			break;
+		default:
+			break;
+	}
+}
+
+
+qint64 Decompressor::decompress( const char *in, qint64 len, QByteArray &out, qint64 maxlen )
+{
+	if ( end )
+		return 0;
+
+	int osize = out.size();
+	out.resize(osize + maxlen);
+	char *dst = out.data() + osize;
+	qint64 consumed = 0, produced = 0;
+
+	switch ( type ) {
+		case CM_GZIP: {
+			z_stream *zs = &d->zstream;
+			zs->next_in = (Bytef *) in;
+			zs->avail_in = qMin(len, (qint64) UINT_MAX);
+			zs->next_out = (Bytef *) dst;
+			zs->avail_out = (uInt) maxlen;
+			int ret = inflate(zs, Z_NO_FLUSH);
+			if ( ret == Z_STREAM_END )
+				end = true;
+			else if ( ret != Z_OK && ret != Z_BUF_ERROR )
+				consumed = -1;
+			if ( consumed == 0 ) {
+				consumed = zs->next_in - (Bytef *) in;
+				produced = maxlen - zs->avail_out;
+			}
+			break;
+		}
+		case CM_ZSTD: {
+			ZSTD_inBuffer input = { in, (size_t) len, 0 };
+			ZSTD_outBuffer output = { dst, (size_t) maxlen, 0 };
+			for (;;) {
+				size_t ret = ZSTD_decompressStream(d->zstd, &output, &input);
+				if ( ZSTD_isError(ret) ) {
+					consumed = -1;
+					break;
+				}
+				if ( ret == 0 ) {
+					end = true;
+					break;
+				}
+				if ( output.pos == output.size || input.pos == input.size )
+					break;
+			}
+			if ( consumed == 0 ) {
+				consumed = input.pos;
+				produced = output.pos;
+			}
+			break;
+		}
+		case CM_BROTLI: {
+			size_t avail_in = len, avail_out = maxlen;
+			const uint8_t *next_in = (const uint8_t *) in;
+			uint8_t *next_out = (uint8_t *) dst;
+			BrotliDecoderResult ret = BrotliDecoderDecompressStream(d->brotli,
+				&avail_in, &next_in, &avail_out, &next_out, NULL);
+			if ( ret == BROTLI_DECODER_RESULT_SUCCESS ) {
+				end = true;
+			} else if ( ret == BROTLI_DECODER_RESULT_ERROR ) {
+				consumed = -1;
+				break;
+			}
+			consumed = len - avail_in;
+			produced = maxlen - avail_out;
+			break;
+		}
+		default:
+			produced = consumed = qMin(len, maxlen);
+			memcpy(dst, in, produced);
+			break;
+	}
+
+	out.resize(osize + produced);
+	return consumed;
+}
+
+
+QByteArray Decompressor::prefix( Compression type, const QByteArray &content, qint64 maxlen )
+{
+	QByteArray out;
+	Decompressor decoder(type);
+	qint64 offset = 0;
+	while ( out.size() < maxlen && offset < content.size() ) {
+		int size = out.size();
+		qint64 consumed = decoder.decompress(content.constData() + offset,
+			content.size() - offset, out, maxlen - out.size());
+		if ( consumed < 0 || (consumed == 0 && out.size() == size && !decoder.atEnd()) )
+			break;
+		offset += consumed;
+		if ( decoder.atEnd() )
+			decoder.reset();
+	}
+	return out;
+}
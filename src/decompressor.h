@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2010, 2011, 2012 by Sergey Urbanovich
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef DECOMPRESSOR_H
+#define DECOMPRESSOR_H
+
+
+#include <QByteArray>
+#include <QString>
+
+enum Compression { CM_UNDEF = -1, CM_AUTO, CM_NONE, CM_GZIP, CM_ZSTD, CM_BROTLI };
+
+Compression compression( const QString &name );
+Compression detectCompression( const QByteArray &content );
+
+struct DecompressorPrivate;
+
+/*
+ * Streaming decoder for gzip, zstd and brotli. Brotli has no magic bytes
+ * so it is never detected, it has to be asked for explicitly.
+ */
+class Decompressor
+{
+public:
+	Decompressor( Compression type );
+	~Decompressor();
+
+	/*
+	 * Decodes input until maxlen bytes are appended to out or input is
+	 * exhausted or the current stream ends. Returns the number of input
+	 * bytes consumed, -1 on corrupted input.
+	 */
+	qint64 decompress( const char *in, qint64 len, QByteArray &out, qint64 maxlen );
+	/* current gzip member or zstd frame is complete */
+	bool atEnd() const;
+	void reset();
+
+	static QByteArray prefix( Compression type, const QByteArray &content, qint64 maxlen );
+
+private:
+	Compression type;
+	bool end;
+	struct DecompressorPrivate *d;
+};
+
+
+#endif /* DECOMPRESSOR_H */
@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2010, 2011, 2012 by Sergey Urbanovich
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include "deduplicator.h"
+
+#define SHINGLE 3
+
+
+static inline quint64 rotl( quint64 x, int r )
+{
+	return (x << r) | (x >> (64 - r));
+}
+
+
+/* splitmix64 finalizer */
+static inline quint64 mix( quint64 x )
+{
+	x ^= x >> 30;
+	x *= 0xbf58476d1ce4e5b9ULL;
+	x ^= x >> 27;
+	x *= 0x94d049bb133111ebULL;
+	x ^= x >> 31;
+	return x;
+}
+
+
+static int popcount( quint64 x )
+{
+	return __builtin_popcountll(x);
+}
+
+
+Deduplicator::Deduplicator( int window, int distance )
+	: ring(window), next(0), filled(0), distance(distance)
+{
+	bands = distance + 1;
+	band_bits = 64 / bands;
+}
+
+
+quint64 Deduplicator::fingerprint( const QString &text )
+{
+	/* FNV-1a hashes of lower case words */
+	QVector<quint64> words;
+	words.reserve(text.length() / 5);
+	quint64 hash = 0;
+	bool word = false;
+	const QChar *ch = text.constData();
+	const QChar *end = ch + text.length();
+	for ( ; ch != end; ++ch ) {
+		if ( ch->isLetterOrNumber() ) {
+			if ( !word ) {
+				hash = 0xcbf29ce484222325ULL;
+				word = true;
+			}
+			hash = (hash ^ ch->toLower().unicode()) * 0x100000001b3ULL;
+		} else if ( word ) {
+			words << hash;
+			word = false;
+		}
+	}
+	if ( word )
+		words << hash;
+	if ( words.isEmpty() )
+		return 0;
+
+	/* shingle hashes, branch free so the loop vectorizes */
+	int count = qMax(words.size() - SHINGLE + 1, 1);
+	QVector<quint64> shingles(count);
+	const quint64 *w = words.constData();
+	quint64 *s = shingles.data();
+	if ( words.size() < SHINGLE ) {
+		s[0] = mix(w[0]);
+	} else {
+		for ( int i = 0; i < count; ++i )
+			s[i] = mix(w[i] ^ rotl(w[i + 1], 21) ^ rotl(w[i + 2], 42));
+	}
+
+	/* every shingle votes for each bit */
+	qint32 votes[64] = { 0 };
+	for ( int i = 0; i < count; ++i ) {
+		quint64 h = s[i];
+		for ( int bit = 0; bit < 64; ++bit )
+			votes[bit] += (qint32) ((h >> bit) & 1) * 2 - 1;
+	}
+
+	quint64 result = 0;
+	for ( int bit = 0; bit < 64; ++bit )
+		if ( votes[bit] > 0 )
+			result |= 1ULL << bit;
+	return result;
+}
+
+
+quint64 Deduplicator::bandKey( quint64 fingerprint, int band ) const
+{
+	int bits = band == bands - 1 ? 64 - band * band_bits : band_bits;
+	quint64 value = (fingerprint >> (band * band_bits)) & (bits == 64 ? ~0ULL : (1ULL << bits) - 1);
+	return mix(value) ^ band;
+}
+
+
+bool Deduplicator::isDuplicate( quint64 fingerprint )
+{
+	bool duplicate = false;
+	for ( int band = 0; band < bands && !duplicate; ++band ) {
+		quint64 key = bandKey(fingerprint, band);
+		QMultiHash<quint64, int>::const_iterator it = index.constFind(key);
+		for ( ; it != index.constEnd() && it.key() == key; ++it ) {
+			if ( popcount(ring.at(it.value()) ^ fingerprint) <= distance ) {
+				duplicate = true;
+				break;
+			}
+		}
+	}
+
+	/* the oldest fingerprint leaves the window and the index */
+	if ( filled == ring.size() ) {
+		for ( int band = 0; band < bands; ++band )
+			index.remove(bandKey(ring.at(next), band), next);
+	} else {
+		filled++;
+	}
+	ring[next] = fingerprint;
+	for ( int band = 0; band < bands; ++band )
+		index.insert(bandKey(fingerprint, band), next);
+	next = (next + 1) % ring.size();
+
+	return duplicate;
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2010, 2011, 2012 by Sergey Urbanovich
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef DEDUPLICATOR_H
+#define DEDUPLICATOR_H
+
+
+#include <QtCore>
+
+#define DEDUP_MAX_DISTANCE 7
+
+/*
+ * Near-duplicate detection of documents by 64-bit SimHash of word
+ * 3-shingles. The last "window" fingerprints are kept in a banded LSH
+ * index: with distance + 1 bands, two fingerprints within the distance
+ * share at least one band, so only those candidates are compared.
+ */
+class Deduplicator
+{
+public:
+	Deduplicator( int window, int distance );
+
+	static quint64 fingerprint( const QString &text );
+	/* checks the fingerprint against the window and adds it */
+	bool isDuplicate( quint64 fingerprint );
+
+private:
+	quint64 bandKey( quint64 fingerprint, int band ) const;
+
+	QVector<quint64> ring;
+	int next;
+	int filled;
+	int distance;
+	int bands;
+	int band_bits;
+	QMultiHash<quint64, int> index;
+};
+
+
+#endif /* DEDUPLICATOR_H */
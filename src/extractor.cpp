@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2010, 2011, 2012 by Sergey Urbanovich
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include "extractor.h"
+
+#define METADATA_SELECTOR "html,meta,link[rel][href],a[href]"
+#define LINKS_SELECTOR    "a[href]"
+
+
+static bool isNavigable( const QUrl &url )
+{
+	QString scheme = url.scheme();
+	return url.isValid() && (scheme == "http" || scheme == "https");
+}
+
+
+/* WebKit resolves the first <base href> against the document url */
+static QUrl documentBase( QWebFrame *frame, const QUrl &baseurl )
+{
+	QUrl base = frame->baseUrl();
+	return base.isValid() && !base.isEmpty() ? base : baseurl;
+}
+
+
+/* resolves an a[href], drops the fragment and repeated links */
+template <class T>
+static void addLink( const QUrl &base, const QWebElement &el, QSet<QString> &seen, QList<T> &links )
+{
+	QUrl url = base.resolved(QUrl(el.attribute("href").trimmed()));
+	url.setFragment(QString());
+	QString href = url.toString();
+	if ( !isNavigable(url) || seen.contains(href) )
+		return;
+	seen.insert(href);
+	links << href;
+}
+
+
+QStringList extractLinks( QWebFrame *frame, const QUrl &baseurl )
+{
+	QUrl base = documentBase(frame, baseurl);
+	QStringList links;
+	QSet<QString> seen;
+
+	foreach (QWebElement el, frame->findAllElements(LINKS_SELECTOR))
+		addLink(base, el, seen, links);
+	return links;
+}
+
+
+QVariantMap extractMetadata( QWebFrame *frame, const QUrl &baseurl )
+{
+	QUrl base = documentBase(frame, baseurl);
+	QString description, canonical, lang;
+	QVariantMap og, twitter;
+	QVariantList links;
+	QSet<QString> seen;
+
+	/* single pass in document order */
+	foreach (QWebElement el, frame->findAllElements(METADATA_SELECTOR)) {
+		QString tag = el.tagName().toLower();
+		if ( tag == "a" ) {
+			addLink(base, el, seen, links);
+		} else if ( tag == "meta" ) {
+			QString name = el.attribute("property");
+			if ( name.isEmpty() )
+				name = el.attribute("name");
+			name = name.trimmed().toLower();
+			QString content = el.attribute("content").trimmed();
+			if ( name == "description" ) {
+				if ( description.isEmpty() )
+					description = content;
+			} else if ( name.startsWith("og:") ) {
+				og.insert(name.mid(3), content);
+			} else if ( name.startsWith("twitter:") ) {
+				twitter.insert(name.mid(8), content);
+			} else if ( lang.isEmpty() &&
+			            el.attribute("http-equiv").compare("content-language", Qt::CaseInsensitive) == 0 ) {
+				lang = content;
+			}
+		} else if ( tag == "link" ) {
+			QStringList rel = el.attribute("rel").toLower().split(' ', QString::SkipEmptyParts);
+			if ( canonical.isEmpty() && rel.contains("canonical") )
+				canonical = base.resolved(QUrl(el.attribute("href").trimmed())).toString();
+		} else if ( tag == "html" ) {
+			lang = el.attribute("lang", el.attribute("xml:lang")).trimmed();
+		}
+	}
+
+	QVariantMap result;
+	result.insert("url", baseurl.toString());
+	result.insert("title", frame->title().simplified());
+	result.insert("description", description);
+	result.insert("canonical", canonical);
+	result.insert("lang", lang);
+	result.insert("og", og);
+	result.insert("twitter", twitter);
+	result.insert("links", links);
+	return result;
+}
+
+
+QVariantMap extractSelected( QWebFrame *frame, const QString &selects )
+{
+	/* fields are grouped by selector, every selector is queried once */
+	QStringList selectors;
+	QHash<QString, QStringList> fields;
+	foreach (const QString &line, selects.split('\n', QString::SkipEmptyParts)) {
+		int space = line.indexOf(' ');
+		QString field = line.left(space), selector = line.mid(space + 1);
+		if ( !fields.contains(selector) )
+			selectors << selector;
+		if ( !fields[selector].contains(field) )
+			fields[selector] << field;
+	}
+
+	QVariantMap result;
+	foreach (const QString &selector, selectors) {
+		const QStringList &names = fields[selector];
+		QVariantList matches;
+		foreach (QWebElement el, frame->findAllElements(selector)) {
+			QVariantMap match;
+			foreach (const QString &name, names) {
+				if ( name == "text" )
+					match.insert(name, el.toPlainText().trimmed());
+				else if ( name == "html" )
+					match.insert(name, el.toOuterXml());
+				/* attributes keep the "@", so @text never clashes with text */
+				else if ( el.hasAttribute(name.mid(1)) )
+					match.insert(name, el.attribute(name.mid(1)));
+			}
+			matches << match;
+		}
+		result.insert(selector, matches);
+	}
+	return result;
+}
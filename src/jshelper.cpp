@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2010, 2011, 2012 by Sergey Urbanovich
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include "jshelper.h"
+
+
+JsHelper::JsHelper( QWebFrame *frame ) : QObject(frame), frame(frame) {}
+
+
+QString JsHelper::elementText( const QWebElement &element )
+{
+	return element.toPlainText().trimmed();
+}
+
+
+double JsHelper::elementLinkDensity( const QWebElement &element )
+{
+	int length = elementText(element).length();
+	if ( length == 0 )
+		return 0;
+
+	int links = 0;
+	foreach (QWebElement a, element.findAll("a"))
+		links += elementText(a).length();
+
+	return (double) links / length;
+}
+
+
+int JsHelper::countWords( const QString &text )
+{
+	int count = 0;
+	bool word = false;
+	const QChar *ch = text.constData();
+	const QChar *end = ch + text.length();
+	for ( ; ch != end; ++ch ) {
+		if ( ch->isSpace() ) {
+			word = false;
+		} else if ( !word ) {
+			word = true;
+			count++;
+		}
+	}
+	return count;
+}
+
+
+QString JsHelper::innerText( const QWebElement &element ) const
+{
+	return elementText(element);
+}
+
+
+double JsHelper::linkDensity( const QWebElement &element ) const
+{
+	return elementLinkDensity(element);
+}
+
+
+int JsHelper::charCount( const QWebElement &element, const QString &s ) const
+{
+	if ( s.isEmpty() )
+		return 0;
+	return elementText(element).count(s);
+}
+
+
+int JsHelper::wordCount( const QString &text ) const
+{
+	return countWords(text);
+}
+
+
+QStringList JsHelper::selectText( const QString &selector ) const
+{
+	QStringList result;
+	foreach (QWebElement el, frame->findAllElements(selector))
+		result << elementText(el);
+	return result;
+}
+
+
+QVariantList JsHelper::selectLinkDensity( const QString &selector ) const
+{
+	QVariantList result;
+	foreach (QWebElement el, frame->findAllElements(selector))
+		result << elementLinkDensity(el);
+	return result;
+}
+
+
+QVariantList JsHelper::selectWordCount( const QString &selector ) const
+{
+	QVariantList result;
+	foreach (QWebElement el, frame->findAllElements(selector))
+		result << countWords(el.toPlainText());
+	return result;
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2010, 2011, 2012 by Sergey Urbanovich
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef JSHELPER_H
+#define JSHELPER_H
+
+
+#include <QtWebKit>
+#include <QObject>
+
+#define JSHELPER_NAME "sketch"
+
+/*
+ * Native helpers exposed to user scripts as window.sketch. Every frame
+ * gets its own instance, so selector based methods work on that frame.
+ */
+class JsHelper : public QObject
+{
+	Q_OBJECT
+	public:
+		JsHelper( QWebFrame *frame );
+
+		static QString elementText( const QWebElement &element );
+		static double elementLinkDensity( const QWebElement &element );
+		static int countWords( const QString &text );
+
+	public slots:
+		QString innerText( const QWebElement &element ) const;
+		double linkDensity( const QWebElement &element ) const;
+		int charCount( const QWebElement &element, const QString &s = "," ) const;
+		int wordCount( const QString &text ) const;
+
+		QStringList selectText( const QString &selector ) const;
+		QVariantList selectLinkDensity( const QString &selector ) const;
+		QVariantList selectWordCount( const QString &selector ) const;
+
+	private:
+		QWebFrame *frame;
+};
+
+
+#endif /* JSHELPER_H */
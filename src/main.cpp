@@ -26,6 +26,7 @@
 
 #include "application.h"
 #include "utils.h"
+#include "trace.h"
 
 int main(int argc, char *argv[])
 {
@@ -36,12 +37,19 @@ int main(int argc, char *argv[])
 	/* always use unicode for stdout */
 	setenv("LANG", "en_US.utf8", 1);
 
+	traceInitialize(argc, argv);
+
+	TraceSpan fontSpan("fontInitialize");
 	fontInitialize(argc, argv);
+	fontSpan.end();
 
 	/* optimizes start-up: 1.5 times faster */
 	QApplication::setGraphicsSystem("raster");
 	QApplication::setStyle(new QWindowsStyle);
 
+	TraceSpan appSpan("QApplication");
 	Application app(argc, argv);
+	appSpan.end();
+
 	return app.exec();
 }
@@ -22,12 +22,16 @@
  */
 
 #include "networkreplystdinimpl.h"
+#include "networkreplyarchiveimpl.h"
+#include "networkreplyrecordimpl.h"
 #include "networkaccessmanager.h"
 #include "utils.h"
+#include "trace.h"
 
 
 NetworkAccessManager::NetworkAccessManager(QUrl url, int allow):
-	baseurl(url), allow_r(allow), running(0) {}
+	baseurl(url), allow_r(allow), running(0), content_compression(CM_NONE),
+	archive(NULL), replay(false) {}
 
 
 bool NetworkAccessManager::isRunning() const
@@ -36,12 +40,36 @@ bool NetworkAccessManager::isRunning() const
 }
 
 
-void NetworkAccessManager::setContent( QByteArray &content, QString &mime )
+const QUrl &NetworkAccessManager::baseUrl() const
 {
-	if ( !content.isEmpty() )
+	return baseurl;
+}
+
+
+void NetworkAccessManager::setBaseUrl( const QUrl &url )
+{
+	baseurl = url;
+	redirects.clear();
+}
+
+
+void NetworkAccessManager::setArchive( NetworkArchive *archive, bool replay )
+{
+	this->archive = archive;
+	this->replay = replay;
+}
+
+
+void NetworkAccessManager::setContent( QByteArray &content, QString &mime, Compression compression )
+{
+	content_compression = compression;
+
+	if ( !content.isEmpty() ) {
 		stdin_content = content;
-	else
+	} else {
 		stdin_content = "<html></html>";
+		content_compression = CM_NONE;
+	}
 
 	if ( !mime.isEmpty() )
 		content_type = mime;
@@ -50,24 +78,63 @@ void NetworkAccessManager::setContent( QByteArray &content, QString &mime )
 }
 
 
-QNetworkReply * NetworkAccessManager::createRequest( Operation op,
-	const QNetworkRequest &req, QIODevice *outgoingData )
+static bool isFont( const QString &path )
 {
-	QNetworkRequest request(req);
-	QString path = request.url().path();
+	return path.endsWith(".woff",  Qt::CaseInsensitive) ||
+	       path.endsWith(".woff2", Qt::CaseInsensitive) ||
+	       path.endsWith(".ttf",   Qt::CaseInsensitive) ||
+	       path.endsWith(".otf",   Qt::CaseInsensitive) ||
+	       path.endsWith(".eot",   Qt::CaseInsensitive);
+}
+
+
+/* blocking some http requests, an allowed redirect target is used up */
+bool NetworkAccessManager::allowRequest( const QUrl &url )
+{
+	QString path = url.path();
 
-	/* blocking some http requests */
-	bool allow = (allow_r & AA_ALL) || (request.url() == baseurl) ||
+	bool allow = (allow_r & AA_ALL) || (url == baseurl) ||
 		( (allow_r & AA_CSS) && path.endsWith(".css", Qt::CaseInsensitive) ) ||
 		( (allow_r & AA_JS)  && path.endsWith(".js",  Qt::CaseInsensitive) ) ||
-		( (allow_r & AA_REDIRECT) && redirects.removeOne(request.url()) );
+		( (allow_r & AA_REDIRECT) && redirects.removeOne(url) );
+
+	if ( (allow_r & AA_NOFONT) && url != baseurl && isFont(path) )
+		allow = false;
+
+	return allow;
+}
+
+
+void NetworkAccessManager::addRedirect( const QUrl &url )
+{
+	redirects << url;
+}
+
+
+QNetworkReply * NetworkAccessManager::createRequest( Operation op,
+	const QNetworkRequest &req, QIODevice *outgoingData )
+{
+	QNetworkRequest request(req);
 
+	bool allow = allowRequest(request.url());
 	if ( !allow )
 		request.setUrl( QUrl(FORBIDDEN_URL) );
 
 	QNetworkReply *reply;
+	ArchiveEntry entry;
 	if ( request.url() == baseurl && !stdin_content.isEmpty() ) {
-		reply = new NetworkReplyStdinImpl(this, op, req, stdin_content, content_type);
+		reply = new NetworkReplyStdinImpl(this, op, req, stdin_content, content_type, content_compression);
+	} else if ( allow && archive && replay ) {
+		/* replay never goes to the network, unrecorded urls are forbidden */
+		if ( archive->find(request.url(), entry) ) {
+			reply = new NetworkReplyArchiveImpl(this, op, request, entry);
+		} else {
+			request.setUrl( QUrl(FORBIDDEN_URL) );
+			reply = QNetworkAccessManager::createRequest(op, request, outgoingData);
+		}
+	} else if ( allow && archive ) {
+		reply = new NetworkReplyRecordImpl(this,
+			QNetworkAccessManager::createRequest(op, request, outgoingData), archive);
 	} else {
 		reply = QNetworkAccessManager::createRequest(op, request, outgoingData);
 	}
@@ -75,6 +142,14 @@ QNetworkReply * NetworkAccessManager::createRequest( Operation op,
 	running++;
 	connect(reply, SIGNAL(finished()), SLOT(onFinished()));
 
+	if ( traceEnabled() ) {
+		QVariantMap args;
+		args.insert("url", req.url().toString());
+		args.insert("allow", allow);
+		traceAsyncBegin("request", reply, args);
+		connect(reply, SIGNAL(downloadProgress(qint64, qint64)), SLOT(onDownloadProgress(qint64, qint64)));
+	}
+
 	return reply;
 }
 
@@ -82,10 +157,22 @@ QNetworkReply * NetworkAccessManager::createRequest( Operation op,
 void NetworkAccessManager::onFinished() {
 	running--;
 
+	if ( traceEnabled() ) {
+		QVariantMap args;
+		args.insert("bytes", sender()->property("bytes"));
+		traceAsyncEnd("request", sender(), args);
+	}
+
 	if ( allow_r & AA_REDIRECT ) {
 		QNetworkReply *reply = (QNetworkReply *) sender();
 		QUrl url = reply->attribute(QNetworkRequest::RedirectionTargetAttribute).toUrl();
 		if ( !url.isEmpty() )
-			redirects << url;
+			addRedirect(url);
 	}
 }
+
+
+void NetworkAccessManager::onDownloadProgress( qint64 received, qint64 )
+{
+	sender()->setProperty("bytes", received);
+}
@@ -26,13 +26,16 @@
 
 
 #include <QtWebKit>
+#include "decompressor.h"
+#include "networkarchive.h"
 
 enum AccessAllow {
 	AA_NONE     = 0,
 	AA_CSS      = 1,
 	AA_JS       = 2,
 	AA_REDIRECT = 4,
-	AA_ALL      = 8
+	AA_ALL      = 8,
+	AA_NOFONT   = 16  /* denies web fonts, even with AA_ALL */
 };
 
 
@@ -42,13 +45,19 @@ class NetworkAccessManager : public QNetworkAccessManager
 	public:
 		NetworkAccessManager( QUrl url, int allow );
 		bool isRunning() const;
-		void setContent( QByteArray &content, QString &mime );
+		const QUrl &baseUrl() const;
+		void setBaseUrl( const QUrl &url );
+		void setArchive( NetworkArchive *archive, bool replay );
+		bool allowRequest( const QUrl &url );
+		void addRedirect( const QUrl &url );
+		void setContent( QByteArray &content, QString &mime, Compression compression = CM_NONE );
 
 	protected:
 		virtual QNetworkReply * createRequest( Operation op, const QNetworkRequest &req, QIODevice *outgoingData );
 
 	public slots:
 		void onFinished();
+		void onDownloadProgress( qint64 received, qint64 );
 
 	private:
 		QUrl baseurl;
@@ -57,6 +66,9 @@ class NetworkAccessManager : public QNetworkAccessManager
 		QList<QUrl> redirects;
 		QByteArray stdin_content;
 		QString content_type;
+		Compression content_compression;
+		NetworkArchive *archive;
+		bool replay;
 };
 
 
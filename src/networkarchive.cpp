@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2010, 2011, 2012 by Sergey Urbanovich
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include "networkarchive.h"
+
+#define ARCHIVE_MAGIC   0x736b6172 /* "skar" */
+#define ARCHIVE_VERSION QDataStream::Qt_4_6
+
+
+NetworkArchive::NetworkArchive( const QString &filename ) : file(filename) {}
+
+
+bool NetworkArchive::load()
+{
+	if ( !file.open(QFile::ReadOnly) ) {
+		qWarning() << "Couldn't read archive" << file.fileName();
+		return false;
+	}
+
+	QDataStream in(&file);
+	in.setVersion(ARCHIVE_VERSION);
+	while ( !in.atEnd() ) {
+		quint32 magic;
+		QByteArray url;
+		qint32 status;
+		ArchiveEntry entry;
+		in >> magic >> url >> status >> entry.headers >> entry.body;
+		if ( in.status() != QDataStream::Ok || magic != ARCHIVE_MAGIC ) {
+			qWarning() << "Archive is broken" << file.fileName();
+			break;
+		}
+		entry.status = status;
+		/* the last response wins, as it would on the network */
+		entries.insert(url, entry);
+	}
+	file.close();
+	return true;
+}
+
+
+bool NetworkArchive::find( const QUrl &url, ArchiveEntry &entry ) const
+{
+	QHash<QByteArray, ArchiveEntry>::const_iterator it = entries.constFind(url.toEncoded());
+	if ( it == entries.constEnd() )
+		return false;
+	entry = it.value();
+	return true;
+}
+
+
+void NetworkArchive::record( const QUrl &url, const ArchiveEntry &entry )
+{
+	if ( !file.isOpen() && !file.open(QFile::WriteOnly | QFile::Append) ) {
+		qWarning() << "Couldn't write archive" << file.fileName();
+		return;
+	}
+
+	QDataStream out(&file);
+	out.setVersion(ARCHIVE_VERSION);
+	out << (quint32) ARCHIVE_MAGIC << url.toEncoded() << (qint32) entry.status
+	    << entry.headers << entry.body;
+	file.flush();
+}
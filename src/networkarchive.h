@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2010, 2011, 2012 by Sergey Urbanovich
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef NETWORKARCHIVE_H
+#define NETWORKARCHIVE_H
+
+
+#include <QtNetwork>
+
+typedef QPair<QByteArray, QByteArray> RawHeader;
+
+struct ArchiveEntry
+{
+	int status;
+	QList<RawHeader> headers;
+	QByteArray body;
+};
+
+/*
+ * Responses keyed by url, for --record and --replay. The file is a
+ * sequence of QDataStream records: url, status, headers, body.
+ */
+class NetworkArchive
+{
+public:
+	NetworkArchive( const QString &filename );
+
+	bool load();
+	bool find( const QUrl &url, ArchiveEntry &entry ) const;
+	void record( const QUrl &url, const ArchiveEntry &entry );
+
+private:
+	QFile file;
+	QHash<QByteArray, ArchiveEntry> entries;
+};
+
+
+#endif /* NETWORKARCHIVE_H */
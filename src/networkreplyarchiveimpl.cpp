@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2010, 2011, 2012 by Sergey Urbanovich
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include "networkreplyarchiveimpl.h"
+
+
+QString NetworkReplyArchiveImpl::contentType( const ArchiveEntry &entry )
+{
+	foreach (const RawHeader &header, entry.headers)
+		if ( header.first.toLower() == "content-type" )
+			return header.second;
+	return "application/octet-stream";
+}
+
+
+NetworkReplyArchiveImpl::NetworkReplyArchiveImpl( QObject *parent,
+	const QNetworkAccessManager::Operation op, const QNetworkRequest &req,
+	const ArchiveEntry &entry )
+	: NetworkReplyStdinImpl(parent, op, req, entry.body, contentType(entry))
+{
+	/* signals are queued by the base class, metadata can be replaced here */
+	setAttribute(QNetworkRequest::HttpStatusCodeAttribute, entry.status);
+	setAttribute(QNetworkRequest::HttpReasonPhraseAttribute, QVariant());
+	foreach (const RawHeader &header, entry.headers)
+		setRawHeader(header.first, header.second);
+
+	if ( entry.status >= 300 && entry.status < 400 && hasRawHeader("Location") ) {
+		QUrl location = QUrl::fromEncoded(rawHeader("Location"));
+		setAttribute(QNetworkRequest::RedirectionTargetAttribute, req.url().resolved(location));
+	}
+}
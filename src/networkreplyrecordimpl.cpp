@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2010, 2011, 2012 by Sergey Urbanovich
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include "networkreplyrecordimpl.h"
+
+
+NetworkReplyRecordImpl::NetworkReplyRecordImpl( QObject *parent,
+	QNetworkReply *reply, NetworkArchive *archive ) : QNetworkReply(parent)
+{
+	d = new NetworkReplyRecordImplPrivate();
+	d->reply = reply;
+	d->archive = archive;
+	d->entry.status = 0;
+	reply->setParent(this);
+
+	setRequest(reply->request());
+	setUrl(reply->url());
+	setOperation(reply->operation());
+	QNetworkReply::open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+
+	connect(reply, SIGNAL(metaDataChanged()), SLOT(onMetaDataChanged()));
+	connect(reply, SIGNAL(readyRead()), SLOT(onReadyRead()));
+	connect(reply, SIGNAL(error(QNetworkReply::NetworkError)), SLOT(onError(QNetworkReply::NetworkError)));
+	connect(reply, SIGNAL(finished()), SLOT(onFinished()));
+	connect(reply, SIGNAL(downloadProgress(qint64, qint64)), SIGNAL(downloadProgress(qint64, qint64)));
+}
+
+
+NetworkReplyRecordImpl::~NetworkReplyRecordImpl()
+{
+	delete d;
+}
+
+
+bool NetworkReplyRecordImpl::isTransportHeader( const QByteArray &name )
+{
+	QByteArray header = name.toLower();
+	return header == "content-length" || header == "content-encoding" ||
+	       header == "transfer-encoding" || header == "connection" ||
+	       header == "keep-alive";
+}
+
+
+void NetworkReplyRecordImpl::abort()
+{
+	d->reply->abort();
+}
+
+
+qint64 NetworkReplyRecordImpl::bytesAvailable() const
+{
+	return d->buffer.size() + QNetworkReply::bytesAvailable();
+}
+
+
+bool NetworkReplyRecordImpl::isSequential() const
+{
+	return true;
+}
+
+
+qint64 NetworkReplyRecordImpl::readData( char *data, qint64 maxlen )
+{
+	if ( d->buffer.isEmpty() )
+		return d->reply->isFinished() ? -1 : 0;
+
+	qint64 number = qMin(maxlen, (qint64) d->buffer.size());
+	memcpy(data, d->buffer.constData(), number);
+	d->buffer.remove(0, number);
+	return number;
+}
+
+
+void NetworkReplyRecordImpl::onMetaDataChanged()
+{
+	QNetworkReply *reply = d->reply;
+	setAttribute(QNetworkRequest::HttpStatusCodeAttribute,
+		reply->attribute(QNetworkRequest::HttpStatusCodeAttribute));
+	setAttribute(QNetworkRequest::HttpReasonPhraseAttribute,
+		reply->attribute(QNetworkRequest::HttpReasonPhraseAttribute));
+	setAttribute(QNetworkRequest::RedirectionTargetAttribute,
+		reply->attribute(QNetworkRequest::RedirectionTargetAttribute));
+
+	d->entry.headers.clear();
+	foreach (const QByteArray &name, reply->rawHeaderList()) {
+		setRawHeader(name, reply->rawHeader(name));
+		if ( !isTransportHeader(name) )
+			d->entry.headers << RawHeader(name, reply->rawHeader(name));
+	}
+	d->entry.status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+
+	emit metaDataChanged();
+}
+
+
+void NetworkReplyRecordImpl::onReadyRead()
+{
+	QByteArray data = d->reply->readAll();
+	d->buffer.append(data);
+	d->entry.body.append(data);
+	emit readyRead();
+}
+
+
+void NetworkReplyRecordImpl::onError( QNetworkReply::NetworkError code )
+{
+	setError(code, d->reply->errorString());
+	emit error(code);
+}
+
+
+void NetworkReplyRecordImpl::onFinished()
+{
+	if ( d->reply->bytesAvailable() )
+		onReadyRead();
+
+	/* http responses, including error statuses, but not network failures */
+	QNetworkReply::NetworkError code = d->reply->error();
+	if ( d->entry.status && (code == QNetworkReply::NoError || code >= QNetworkReply::ContentAccessDenied) )
+		d->archive->record(url(), d->entry);
+	d->entry.body.clear();
+
+	emit finished();
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2010, 2011, 2012 by Sergey Urbanovich
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef NETWORKREPLYRECORDIMPL_H
+#define NETWORKREPLYRECORDIMPL_H
+
+
+#include <QtWebKit>
+#include "networkarchive.h"
+
+struct NetworkReplyRecordImplPrivate
+{
+	QNetworkReply *reply;
+	NetworkArchive *archive;
+	QByteArray buffer;
+	ArchiveEntry entry;
+};
+
+/* passes a network reply through and stores it in the archive, see --record */
+class NetworkReplyRecordImpl: public QNetworkReply
+{
+	Q_OBJECT
+public:
+	NetworkReplyRecordImpl( QObject *parent, QNetworkReply *reply, NetworkArchive *archive );
+	~NetworkReplyRecordImpl();
+	virtual void abort();
+
+	virtual qint64 bytesAvailable() const;
+	virtual bool isSequential() const;
+
+	/* headers which don't describe the stored body */
+	static bool isTransportHeader( const QByteArray &name );
+
+protected:
+	virtual qint64 readData( char *data, qint64 maxlen );
+
+private slots:
+	void onMetaDataChanged();
+	void onReadyRead();
+	void onError( QNetworkReply::NetworkError code );
+	void onFinished();
+
+private:
+	struct NetworkReplyRecordImplPrivate *d;
+};
+
+
+#endif /* NETWORKREPLYRECORDIMPL_H */
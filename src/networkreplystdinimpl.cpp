@@ -23,10 +23,13 @@
 
 #include "networkreplystdinimpl.h"
 
+#define DECOMPRESS_CHUNK (64 * 1024)
+
 
 NetworkReplyStdinImpl::NetworkReplyStdinImpl( QObject *parent,
 	const QNetworkAccessManager::Operation op, const QNetworkRequest &req,
-	QByteArray &content, QString &content_type ) : QNetworkReply(parent)
+	const QByteArray &content, const QString &content_type, Compression compression )
+	: QNetworkReply(parent)
 {
 	d = new NetworkReplyStdinImplPrivate(),
 	setRequest(req);
@@ -38,10 +41,21 @@ NetworkReplyStdinImpl::NetworkReplyStdinImpl( QObject *parent,
 
 	d->offset = 0;
 	d->content = content;
+	d->decoder = NULL;
+	d->boffset = 0;
 	QNetworkReply::open(QIODevice::ReadOnly | QIODevice::Unbuffered);
 
-	qint64 bsize = d->content.size();
 	setHeader(QNetworkRequest::ContentTypeHeader, content_type);
+
+	if ( compression != CM_NONE ) {
+		/* decompressed size is unknown, content is fed to webkit chunk by chunk */
+		d->decoder = new Decompressor(compression);
+		QMetaObject::invokeMethod(this, "metaDataChanged", Qt::QueuedConnection);
+		decompressChunk();
+		return;
+	}
+
+	qint64 bsize = d->content.size();
 	setHeader(QNetworkRequest::ContentLengthHeader, bsize);
 	QMetaObject::invokeMethod(this, "metaDataChanged", Qt::QueuedConnection);
 	QMetaObject::invokeMethod(this, "downloadProgress", Qt::QueuedConnection,
@@ -53,15 +67,51 @@ NetworkReplyStdinImpl::NetworkReplyStdinImpl( QObject *parent,
 
 NetworkReplyStdinImpl::~NetworkReplyStdinImpl()
 {
+	delete d->decoder;
 	delete d;
 }
 
 
+void NetworkReplyStdinImpl::decompressChunk()
+{
+	d->buffer.clear();
+	d->boffset = 0;
+
+	while ( d->buffer.isEmpty() && d->offset < d->content.size() ) {
+		qint64 consumed = d->decoder->decompress(d->content.constData() + d->offset,
+			d->content.size() - d->offset, d->buffer, DECOMPRESS_CHUNK);
+		if ( consumed < 0 ) {
+			qWarning() << "Couldn't decompress content";
+			setError(QNetworkReply::UnknownContentError, "Couldn't decompress content");
+			break;
+		}
+		d->offset += consumed;
+		if ( d->decoder->atEnd() ) {
+			/* concatenated gzip members or zstd frames */
+			d->decoder->reset();
+		} else if ( consumed == 0 && d->buffer.isEmpty() ) {
+			qWarning() << "Compressed content is truncated";
+			break;
+		}
+	}
+
+	if ( d->buffer.isEmpty() ) {
+		QMetaObject::invokeMethod(this, "finished", Qt::QueuedConnection);
+		return;
+	}
+	QMetaObject::invokeMethod(this, "downloadProgress", Qt::QueuedConnection,
+	                          Q_ARG(qint64, d->offset), Q_ARG(qint64, d->content.size()));
+	QMetaObject::invokeMethod(this, "readyRead", Qt::QueuedConnection);
+}
+
+
 void NetworkReplyStdinImpl::abort() {}
 
 
 qint64 NetworkReplyStdinImpl::bytesAvailable() const
 {
+	if ( d->decoder )
+		return d->buffer.size() - d->boffset + QNetworkReply::bytesAvailable();
 	return d->content.size() - d->offset;
 }
 
@@ -74,6 +124,17 @@ bool NetworkReplyStdinImpl::isSequential() const
 
 qint64 NetworkReplyStdinImpl::readData( char *data, qint64 maxlen )
 {
+	if ( d->decoder ) {
+		if ( d->boffset >= d->buffer.size() )
+			return -1;
+		qint64 number = qMin(maxlen, d->buffer.size() - d->boffset);
+		memcpy(data, d->buffer.constData() + d->boffset, number);
+		d->boffset += number;
+		if ( d->boffset >= d->buffer.size() )
+			decompressChunk();
+		return number;
+	}
+
 	if ( d->offset >= d->content.size() ) {
 		return -1;
 	}
@@ -26,11 +26,15 @@
 
 
 #include <QtWebKit>
+#include "decompressor.h"
 
 struct NetworkReplyStdinImplPrivate
 {
 	QByteArray content;
 	qint64 offset;
+	Decompressor *decoder;
+	QByteArray buffer;
+	qint64 boffset;
 };
 
 class NetworkReplyStdinImpl: public QNetworkReply
@@ -38,7 +42,8 @@ class NetworkReplyStdinImpl: public QNetworkReply
 	Q_OBJECT
 public:
 	NetworkReplyStdinImpl( QObject *parent, const QNetworkAccessManager::Operation op,
-		const QNetworkRequest &req, QByteArray &content, QString &content_type );
+		const QNetworkRequest &req, const QByteArray &content, const QString &content_type,
+		Compression compression = CM_NONE );
 	~NetworkReplyStdinImpl();
 	virtual void abort();
 
@@ -48,6 +53,9 @@ public:
 protected:
 	virtual qint64 readData( char *data, qint64 maxlen );
 
+private:
+	void decompressChunk();
+
 private:
 	struct NetworkReplyStdinImplPrivate *d;
 };
@@ -0,0 +1,469 @@
+/*
+ * Copyright (C) 2010, 2011, 2012 by Sergey Urbanovich
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <QStringList>
+#include <QDateTime>
+#include <qnumeric.h>
+#include <math.h>
+
+#include "serializer.h"
+
+
+ValueFormat valueFormat( const QString &name )
+{
+	if ( name == "json" )
+		return VF_JSON;
+	else if ( name == "cbor" )
+		return VF_CBOR;
+	else if ( name == "msgpack" )
+		return VF_MSGPACK;
+	return VF_UNDEF;
+}
+
+
+/* javascript numbers are doubles, integral ones are written as integers */
+static bool isInteger( double value )
+{
+	return value == floor(value) && fabs(value) < 9007199254740992.0;
+}
+
+
+static void putBE( QByteArray &out, quint64 value, int size )
+{
+	for ( int i = size - 1; i >= 0; --i )
+		out.append((char) ((value >> (8 * i)) & 0xff));
+}
+
+
+static void putDouble( QByteArray &out, double value )
+{
+	quint64 bits;
+	memcpy(&bits, &value, sizeof(bits));
+	putBE(out, bits, 8);
+}
+
+
+static QString dateString( const QDateTime &date )
+{
+	return date.toUTC().toString("yyyy-MM-ddThh:mm:ss.zzzZ");
+}
+
+
+/* JSON */
+
+static void jsonString( const QString &str, QByteArray &out )
+{
+	static const char hex[] = "0123456789abcdef";
+	QByteArray utf8 = str.toUtf8();
+	out.reserve(out.size() + utf8.size() + 2);
+	out.append('"');
+	for ( const char *ch = utf8.constData(), *end = ch + utf8.size(); ch != end; ++ch ) {
+		unsigned char c = *ch;
+		switch ( c ) {
+			case '"':  out.append("\\\""); break;
+			case '\\': out.append("\\\\"); break;
+			case '\b': out.append("\\b");  break;
+			case '\f': out.append("\\f");  break;
+			case '\n': out.append("\\n");  break;
+			case '\r': out.append("\\r");  break;
+			case '\t': out.append("\\t");  break;
+			default:
+				if ( c < 0x20 ) {
+					out.append("\\u00");
+					out.append(hex[c >> 4]);
+					out.append(hex[c & 0xf]);
+				} else {
+					out.append(*ch);
+				}
+		}
+	}
+	out.append('"');
+}
+
+
+/* Number.prototype.toString: shortest digits that read back, the layout of JSON.stringify */
+static void jsonNumber( double value, QByteArray &out )
+{
+	if ( qIsNaN(value) || qIsInf(value) ) {
+		out.append("null");
+		return;
+	} else if ( isInteger(value) ) {
+		out.append(QByteArray::number((qint64) value));
+		return;
+	}
+
+	/* "d.ddde-07": k digits, the point goes after n of them */
+	QByteArray number;
+	for ( int precision = 0; precision < 17; ++precision ) {
+		number = QByteArray::number(fabs(value), 'e', precision);
+		if ( number.toDouble() == fabs(value) )
+			break;
+	}
+	int e = number.indexOf('e');
+	QByteArray digits = number.left(e).replace(".", "");
+	int n = number.mid(e + 1).toInt() + 1, k = digits.size();
+
+	if ( value < 0 )
+		out.append('-');
+	if ( k <= n && n <= 21 ) {
+		out.append(digits).append(QByteArray(n - k, '0'));
+	} else if ( 0 < n && n <= 21 ) {
+		out.append(digits.left(n)).append('.').append(digits.mid(n));
+	} else if ( -6 < n && n <= 0 ) {
+		out.append("0.").append(QByteArray(-n, '0')).append(digits);
+	} else {
+		out.append(digits.at(0));
+		if ( k > 1 )
+			out.append('.').append(digits.mid(1));
+		out.append('e').append(n > 0 ? '+' : '-').append(QByteArray::number(qAbs(n - 1)));
+	}
+}
+
+
+static void json( const QVariant &value, QByteArray &out )
+{
+	switch ( value.type() ) {
+		case QVariant::Invalid:
+			out.append("null");
+			break;
+		case QVariant::Bool:
+			out.append(value.toBool() ? "true" : "false");
+			break;
+		case QVariant::Int:
+		case QVariant::LongLong:
+			out.append(QByteArray::number(value.toLongLong()));
+			break;
+		case QVariant::UInt:
+		case QVariant::ULongLong:
+			out.append(QByteArray::number(value.toULongLong()));
+			break;
+		case QVariant::Double:
+			jsonNumber(value.toDouble(), out);
+			break;
+		case QVariant::DateTime:
+			jsonString(dateString(value.toDateTime()), out);
+			break;
+		case QVariant::StringList:
+		case QVariant::List: {
+			QVariantList list = value.toList();
+			out.append('[');
+			for ( int i = 0; i < list.size(); ++i ) {
+				if ( i )
+					out.append(',');
+				json(list.at(i), out);
+			}
+			out.append(']');
+			break;
+		}
+		case QVariant::Map: {
+			QVariantMap map = value.toMap();
+			out.append('{');
+			for ( QVariantMap::const_iterator it = map.constBegin(); it != map.constEnd(); ++it ) {
+				if ( it != map.constBegin() )
+					out.append(',');
+				jsonString(it.key(), out);
+				out.append(':');
+				json(it.value(), out);
+			}
+			out.append('}');
+			break;
+		}
+		default:
+			if ( value.canConvert(QVariant::String) )
+				jsonString(value.toString(), out);
+			else
+				out.append("{}");
+	}
+}
+
+
+/* CBOR (RFC 7049) */
+
+static void cborHead( int major, quint64 value, QByteArray &out )
+{
+	major <<= 5;
+	if ( value < 24 ) {
+		out.append((char) (major | value));
+	} else if ( value <= 0xff ) {
+		out.append((char) (major | 24));
+		putBE(out, value, 1);
+	} else if ( value <= 0xffff ) {
+		out.append((char) (major | 25));
+		putBE(out, value, 2);
+	} else if ( value <= 0xffffffffULL ) {
+		out.append((char) (major | 26));
+		putBE(out, value, 4);
+	} else {
+		out.append((char) (major | 27));
+		putBE(out, value, 8);
+	}
+}
+
+
+static void cborInteger( qint64 value, QByteArray &out )
+{
+	if ( value >= 0 )
+		cborHead(0, value, out);
+	else
+		cborHead(1, -1 - value, out);
+}
+
+
+static void cborString( const QString &str, QByteArray &out )
+{
+	QByteArray utf8 = str.toUtf8();
+	cborHead(3, utf8.size(), out);
+	out.append(utf8);
+}
+
+
+static void cbor( const QVariant &value, QByteArray &out )
+{
+	switch ( value.type() ) {
+		case QVariant::Invalid:
+			out.append((char) 0xf6);
+			break;
+		case QVariant::Bool:
+			out.append((char) (value.toBool() ? 0xf5 : 0xf4));
+			break;
+		case QVariant::Int:
+		case QVariant::LongLong:
+			cborInteger(value.toLongLong(), out);
+			break;
+		case QVariant::UInt:
+		case QVariant::ULongLong:
+			cborHead(0, value.toULongLong(), out);
+			break;
+		case QVariant::Double: {
+			double number = value.toDouble();
+			if ( isInteger(number) ) {
+				cborInteger((qint64) number, out);
+			} else {
+				out.append((char) 0xfb);
+				putDouble(out, number);
+			}
+			break;
+		}
+		case QVariant::DateTime:
+			cborString(dateString(value.toDateTime()), out);
+			break;
+		case QVariant::ByteArray: {
+			QByteArray bytes = value.toByteArray();
+			cborHead(2, bytes.size(), out);
+			out.append(bytes);
+			break;
+		}
+		case QVariant::StringList:
+		case QVariant::List: {
+			QVariantList list = value.toList();
+			cborHead(4, list.size(), out);
+			foreach (const QVariant &item, list)
+				cbor(item, out);
+			break;
+		}
+		case QVariant::Map: {
+			QVariantMap map = value.toMap();
+			cborHead(5, map.size(), out);
+			for ( QVariantMap::const_iterator it = map.constBegin(); it != map.constEnd(); ++it ) {
+				cborString(it.key(), out);
+				cbor(it.value(), out);
+			}
+			break;
+		}
+		default:
+			if ( value.canConvert(QVariant::String) ) {
+				cborString(value.toString(), out);
+			} else {
+				cborHead(5, 0, out);
+			}
+	}
+}
+
+
+/* MessagePack */
+
+static void msgpackHead( quint8 fix, int fixbits, quint8 type16, quint64 value, QByteArray &out )
+{
+	if ( value < (1U << fixbits) ) {
+		out.append((char) (fix | value));
+	} else if ( value <= 0xffff ) {
+		out.append((char) type16);
+		putBE(out, value, 2);
+	} else {
+		out.append((char) (type16 + 1));
+		putBE(out, value, 4);
+	}
+}
+
+
+static void msgpackInteger( qint64 value, QByteArray &out )
+{
+	if ( value >= 0 ) {
+		if ( value < 0x80 ) {
+			out.append((char) value);
+		} else if ( value <= 0xff ) {
+			out.append((char) 0xcc);
+			putBE(out, value, 1);
+		} else if ( value <= 0xffff ) {
+			out.append((char) 0xcd);
+			putBE(out, value, 2);
+		} else if ( value <= 0xffffffffLL ) {
+			out.append((char) 0xce);
+			putBE(out, value, 4);
+		} else {
+			out.append((char) 0xcf);
+			putBE(out, value, 8);
+		}
+	} else {
+		if ( value >= -32 ) {
+			out.append((char) value);
+		} else if ( value >= -0x80 ) {
+			out.append((char) 0xd0);
+			putBE(out, value, 1);
+		} else if ( value >= -0x8000 ) {
+			out.append((char) 0xd1);
+			putBE(out, value, 2);
+		} else if ( value >= -0x80000000LL ) {
+			out.append((char) 0xd2);
+			putBE(out, value, 4);
+		} else {
+			out.append((char) 0xd3);
+			putBE(out, value, 8);
+		}
+	}
+}
+
+
+static void msgpackString( const QString &str, QByteArray &out )
+{
+	QByteArray utf8 = str.toUtf8();
+	if ( utf8.size() < 32 ) {
+		out.append((char) (0xa0 | utf8.size()));
+	} else if ( utf8.size() <= 0xff ) {
+		out.append((char) 0xd9);
+		putBE(out, utf8.size(), 1);
+	} else if ( utf8.size() <= 0xffff ) {
+		out.append((char) 0xda);
+		putBE(out, utf8.size(), 2);
+	} else {
+		out.append((char) 0xdb);
+		putBE(out, utf8.size(), 4);
+	}
+	out.append(utf8);
+}
+
+
+static void msgpack( const QVariant &value, QByteArray &out )
+{
+	switch ( value.type() ) {
+		case QVariant::Invalid:
+			out.append((char) 0xc0);
+			break;
+		case QVariant::Bool:
+			out.append((char) (value.toBool() ? 0xc3 : 0xc2));
+			break;
+		case QVariant::Int:
+		case QVariant::LongLong:
+			msgpackInteger(value.toLongLong(), out);
+			break;
+		case QVariant::UInt:
+		case QVariant::ULongLong: {
+			quint64 number = value.toULongLong();
+			if ( number > 0x7fffffffffffffffULL ) {
+				out.append((char) 0xcf);
+				putBE(out, number, 8);
+			} else {
+				msgpackInteger(number, out);
+			}
+			break;
+		}
+		case QVariant::Double: {
+			double number = value.toDouble();
+			if ( isInteger(number) ) {
+				msgpackInteger((qint64) number, out);
+			} else {
+				out.append((char) 0xcb);
+				putDouble(out, number);
+			}
+			break;
+		}
+		case QVariant::DateTime:
+			msgpackString(dateString(value.toDateTime()), out);
+			break;
+		case QVariant::ByteArray: {
+			QByteArray bytes = value.toByteArray();
+			if ( bytes.size() <= 0xff ) {
+				out.append((char) 0xc4);
+				putBE(out, bytes.size(), 1);
+			} else if ( bytes.size() <= 0xffff ) {
+				out.append((char) 0xc5);
+				putBE(out, bytes.size(), 2);
+			} else {
+				out.append((char) 0xc6);
+				putBE(out, bytes.size(), 4);
+			}
+			out.append(bytes);
+			break;
+		}
+		case QVariant::StringList:
+		case QVariant::List: {
+			QVariantList list = value.toList();
+			msgpackHead(0x90, 4, 0xdc, list.size(), out);
+			foreach (const QVariant &item, list)
+				msgpack(item, out);
+			break;
+		}
+		case QVariant::Map: {
+			QVariantMap map = value.toMap();
+			msgpackHead(0x80, 4, 0xde, map.size(), out);
+			for ( QVariantMap::const_iterator it = map.constBegin(); it != map.constEnd(); ++it ) {
+				msgpackString(it.key(), out);
+				msgpack(it.value(), out);
+			}
+			break;
+		}
+		default:
+			if ( value.canConvert(QVariant::String) )
+				msgpackString(value.toString(), out);
+			else
+				out.append((char) 0x80);
+	}
+}
+
+
+void serialize( const QVariant &value, ValueFormat format, QByteArray &out )
+{
+	switch ( format ) {
+		case VF_JSON:
+			json(value, out);
+			break;
+		case VF_CBOR:
+			cbor(value, out);
+			break;
+		case VF_MSGPACK:
+			msgpack(value, out);
+			break;
+		default:
+			break;
+	}
+}
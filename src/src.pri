@@ -0,0 +1,48 @@
+# Sources shared by sketch, bench/ and test/, everything but main.cpp and
+# application.cpp. New source files are added here.
+
+INCLUDEPATH += $$PWD
+DEPENDPATH  += $$PWD
+HEADERS += $$PWD/utils.h \
+           $$PWD/webpage.h \
+           $$PWD/networkaccessmanager.h \
+           $$PWD/networkreplystdinimpl.h \
+           $$PWD/jshelper.h \
+           $$PWD/serializer.h \
+           $$PWD/extractor.h \
+           $$PWD/trace.h \
+           $$PWD/decompressor.h \
+           $$PWD/warcreader.h \
+           $$PWD/textcleaner.h \
+           $$PWD/networkarchive.h \
+           $$PWD/networkreplyarchiveimpl.h \
+           $$PWD/networkreplyrecordimpl.h \
+           $$PWD/crawler.h \
+           $$PWD/deduplicator.h
+SOURCES += $$PWD/utils.cpp \
+           $$PWD/webpage.cpp \
+           $$PWD/networkaccessmanager.cpp \
+           $$PWD/networkreplystdinimpl.cpp \
+           $$PWD/jshelper.cpp \
+           $$PWD/serializer.cpp \
+           $$PWD/extractor.cpp \
+           $$PWD/trace.cpp \
+           $$PWD/decompressor.cpp \
+           $$PWD/warcreader.cpp \
+           $$PWD/textcleaner.cpp \
+           $$PWD/networkarchive.cpp \
+           $$PWD/networkreplyarchiveimpl.cpp \
+           $$PWD/networkreplyrecordimpl.cpp \
+           $$PWD/crawler.cpp \
+           $$PWD/deduplicator.cpp
+
+unix {
+    QMAKE_CXXFLAGS += $$system(icu-config --cppflags)
+    LIBS += $$system(icu-config --ldflags)
+    LIBS += -lz -lzstd -lbrotlidec
+}
+
+x11 {
+    CONFIG    += link_pkgconfig
+    PKGCONFIG += fontconfig
+}
@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2010, 2011, 2012 by Sergey Urbanovich
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif /* __SSE2__ */
+
+#include "unicode/utypes.h"
+#include "unicode/unorm2.h"
+
+#include "textcleaner.h"
+
+/* pending separator, the strongest one of a run wins */
+enum { SP_NONE, SP_SPACE, SP_LINE, SP_PARAGRAPH };
+
+
+/* length of the leading run of printable ascii characters, 16 bytes at a time */
+static inline int printableRun( const char *p, int n )
+{
+	int i = 0;
+#ifdef __SSE2__
+	const __m128i low = _mm_set1_epi8(0x20);
+	const __m128i high = _mm_set1_epi8(0x7f);
+	for ( ; i + 16 <= n; i += 16 ) {
+		/* signed compare: bytes >= 0x80 are negative and fail the first test */
+		__m128i v = _mm_loadu_si128((const __m128i *) (p + i));
+		__m128i ok = _mm_and_si128(_mm_cmpgt_epi8(v, low), _mm_cmplt_epi8(v, high));
+		int mask = _mm_movemask_epi8(ok);
+		if ( mask != 0xffff )
+			return i + __builtin_ctz(~mask);
+	}
+#endif /* __SSE2__ */
+	for ( ; i < n; ++i ) {
+		unsigned char c = p[i];
+		if ( c <= 0x20 || c >= 0x7f )
+			break;
+	}
+	return i;
+}
+
+
+static void cleanUtf8( const char *p, int n, QByteArray &out )
+{
+	out.resize(n);
+	char *dst = out.data();
+	char *start = dst;
+	int pending = SP_NONE;
+	int i = 0;
+
+	while ( i < n ) {
+		int run = printableRun(p + i, n - i);
+		if ( run ) {
+			if ( pending && dst != start ) {
+				if ( pending == SP_PARAGRAPH )
+					*dst++ = '\n';
+				*dst++ = pending == SP_SPACE ? ' ' : '\n';
+			}
+			pending = SP_NONE;
+			memcpy(dst, p + i, run);
+			dst += run;
+			i += run;
+			continue;
+		}
+
+		unsigned char c = p[i];
+		int length = 1, kind = -1;
+		if ( c == ' ' || c == '\t' || c == '\f' || c == '\v' || c == '\r' ) {
+			kind = SP_SPACE;
+		} else if ( c == '\n' ) {
+			kind = SP_LINE;
+		} else if ( c < 0x20 || c == 0x7f ) {
+			kind = SP_NONE; /* control character, dropped */
+		} else if ( c == 0xc2 && i + 1 < n ) {
+			unsigned char c1 = p[i + 1];
+			if ( c1 == 0xa0 )
+				kind = SP_SPACE, length = 2; /* no-break space */
+			else if ( c1 < 0xa0 )
+				kind = SP_NONE, length = 2; /* C1 control */
+		} else if ( c == 0xe2 && i + 2 < n && (unsigned char) p[i + 1] == 0x81 &&
+		            (unsigned char) p[i + 2] == 0xa3 ) {
+			kind = SP_PARAGRAPH, length = 3; /* U+2063 invisible separator */
+		}
+
+		if ( kind < 0 ) {
+			/* other non-ascii character, copied as is */
+			if ( pending && dst != start ) {
+				if ( pending == SP_PARAGRAPH )
+					*dst++ = '\n';
+				*dst++ = pending == SP_SPACE ? ' ' : '\n';
+			}
+			pending = SP_NONE;
+			*dst++ = c;
+			i++;
+			continue;
+		}
+
+		if ( kind > pending )
+			pending = kind;
+		i += length;
+	}
+
+	out.resize(dst - start);
+}
+
+
+static QString normalize( const QString &text )
+{
+	UErrorCode status = U_ZERO_ERROR;
+	const UNormalizer2 *nfc = unorm2_getNFCInstance(&status);
+	if ( U_FAILURE(status) )
+		return text;
+
+	const UChar *src = (const UChar *) text.utf16();
+	int32_t span = unorm2_spanQuickCheckYes(nfc, src, text.length(), &status);
+	if ( U_FAILURE(status) || span == text.length() )
+		return text;
+
+	/* NFC rarely grows the text, retry once with the exact size if it does */
+	QString result(text.length(), Qt::Uninitialized);
+	int32_t length = unorm2_normalize(nfc, src, text.length(),
+		(UChar *) result.data(), result.length(), &status);
+	if ( status == U_BUFFER_OVERFLOW_ERROR ) {
+		status = U_ZERO_ERROR;
+		result.resize(length);
+		length = unorm2_normalize(nfc, src, text.length(),
+			(UChar *) result.data(), result.length(), &status);
+	}
+	if ( U_FAILURE(status) )
+		return text;
+	result.resize(length);
+	return result;
+}
+
+
+QByteArray cleanText( const QString &text, int flags )
+{
+	QByteArray utf8 = (flags & TC_NFC ? normalize(text) : text).toUtf8();
+	QByteArray out;
+	cleanUtf8(utf8.constData(), utf8.size(), out);
+	return out;
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2010, 2011, 2012 by Sergey Urbanovich
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <stdio.h>
+#include <string.h>
+
+#include "trace.h"
+#include "serializer.h"
+
+static FILE *trace_file = NULL;
+static QElapsedTimer trace_timer;
+static bool trace_first = true;
+
+
+static qint64 now()
+{
+	return trace_timer.nsecsElapsed() / 1000;
+}
+
+
+static void traceEvent( const char *ph, const char *name, qint64 ts,
+	qint64 dur, const void *id, const QVariantMap &args )
+{
+	QByteArray event(trace_first ? "" : ",\n");
+	trace_first = false;
+
+	event += "{\"name\":";
+	serialize(QString(name), VF_JSON, event);
+	event += ",\"cat\":\"sketch\",\"ph\":\"";
+	event += ph;
+	event += "\",\"ts\":" + QByteArray::number(ts);
+	if ( dur >= 0 )
+		event += ",\"dur\":" + QByteArray::number(dur);
+	if ( id )
+		event += ",\"id\":\"0x" + QByteArray::number((quintptr) id, 16) + "\"";
+	event += ",\"pid\":" + QByteArray::number(QCoreApplication::applicationPid());
+	event += ",\"tid\":1";
+	if ( !args.isEmpty() ) {
+		event += ",\"args\":";
+		serialize(args, VF_JSON, event);
+	}
+	event += "}";
+
+	fwrite(event.constData(), 1, event.size(), trace_file);
+}
+
+
+static void traceFinalize()
+{
+	fputs("\n]\n", trace_file);
+	fclose(trace_file);
+	trace_file = NULL;
+}
+
+
+void traceInitialize( int argc, char *argv[] )
+{
+	/* takes "--trace FILE" before QApplication, so start-up is traced too */
+	for (int i = 0; i < argc - 1; i++) {
+		if ( strcmp(argv[i], "--trace") )
+			continue;
+		if ( !(trace_file = fopen(argv[i + 1], "w")) ) {
+			qWarning() << "Couldn't open trace file" << argv[i + 1];
+			return;
+		}
+		trace_timer.start();
+		fputs("[\n", trace_file);
+		atexit(traceFinalize);
+		return;
+	}
+}
+
+
+bool traceEnabled()
+{
+	return trace_file != NULL;
+}
+
+
+void traceAsyncBegin( const char *name, const void *id, const QVariantMap &args )
+{
+	if ( trace_file )
+		traceEvent("b", name, now(), -1, id, args);
+}
+
+
+void traceAsyncEnd( const char *name, const void *id, const QVariantMap &args )
+{
+	if ( trace_file )
+		traceEvent("e", name, now(), -1, id, args);
+}
+
+
+TraceSpan::TraceSpan( const char *name ) : name(name), start(-1)
+{
+	if ( trace_file )
+		start = now();
+}
+
+
+TraceSpan::~TraceSpan()
+{
+	end();
+}
+
+
+void TraceSpan::setArg( const QString &key, const QVariant &value )
+{
+	if ( start >= 0 )
+		args.insert(key, value);
+}
+
+
+void TraceSpan::end()
+{
+	if ( start < 0 || !trace_file )
+		return;
+	traceEvent("X", name, start, now() - start, NULL, args);
+	start = -1;
+}
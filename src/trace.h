@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2010, 2011, 2012 by Sergey Urbanovich
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+
+#include <QVariant>
+
+/*
+ * Chrome trace-event output (--trace FILE), loadable in chrome://tracing
+ * and Perfetto. Every call is a no-op when tracing is disabled.
+ */
+void traceInitialize( int argc, char *argv[] );
+bool traceEnabled();
+void traceAsyncBegin( const char *name, const void *id, const QVariantMap &args = QVariantMap() );
+void traceAsyncEnd( const char *name, const void *id, const QVariantMap &args = QVariantMap() );
+
+class TraceSpan
+{
+public:
+	TraceSpan( const char *name );
+	~TraceSpan();
+	void setArg( const QString &key, const QVariant &value );
+	void end();
+
+private:
+	const char *name;
+	qint64 start;
+	QVariantMap args;
+};
+
+
+#endif /* TRACE_H */
@@ -32,6 +32,11 @@
 
 #include "utils.h"
 
+#if defined (Q_OS_UNIX)
+#include "unicode/utypes.h"
+#include "unicode/ucsdet.h"
+#endif
+
 
 void fontInitialize(int argc, char *argv[])
 {
@@ -61,3 +66,62 @@ void fontInitialize(int argc, char *argv[])
 
 #endif /* Q_WS_X11 */
 }
+
+
+QString detectEncoding( const QByteArray &content )
+{
+#if defined (Q_OS_UNIX)
+	const UCharsetMatch **csm;
+	const char *encoding;
+	int32_t matchCount = 0;
+	UErrorCode status = U_ZERO_ERROR;
+
+	UCharsetDetector *csd = ucsdet_open(&status);
+
+	ucsdet_setText(csd, content.constData(), content.size(), &status);
+	if ( U_FAILURE(status) )
+		goto fail;
+
+	csm = ucsdet_detectAll(csd, &matchCount, &status);
+	if ( U_FAILURE(status) || matchCount == 0 )
+		goto fail;
+
+	encoding = ucsdet_getName(csm[0], &status);
+	if ( U_FAILURE(status) )
+		goto fail;
+
+	if ( matchCount > 1 ) {
+		int max_confidence = ucsdet_getConfidence(csm[0], &status);
+		if ( U_FAILURE(status) )
+			goto fail;
+		for ( int count = 0; count < matchCount; ++count ) {
+			int confidence = ucsdet_getConfidence(csm[count], &status);
+			if ( U_FAILURE(status) )
+				goto fail;
+			if ( confidence < 0.9 * max_confidence )
+				break;
+			const char *lang = ucsdet_getLanguage(csm[count], &status);
+			if ( U_FAILURE(status) )
+				goto fail;
+			if ( (lang[0] == 'e' && lang[1] == 'n') || /* english    */
+			     (lang[0] == 'e' && lang[1] == 's') || /* spanish    */
+			     (lang[0] == 'p' && lang[1] == 't') || /* portuguese */
+			     (lang[0] == 'd' && lang[1] == 'e') || /* german     */
+			     (lang[0] == 'f' && lang[1] == 'r') || /* french     */
+			     (lang[0] == 'i' && lang[1] == 't')    /* italian    */
+			) {
+				encoding = ucsdet_getName(csm[count], &status);
+				if ( U_FAILURE(status) )
+					goto fail;
+			}
+		}
+	}
+
+	ucsdet_close(csd);
+	return encoding;
+
+fail:
+	ucsdet_close(csd);
+#endif
+	return "";
+}
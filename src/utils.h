@@ -25,9 +25,13 @@
 #define UTILS_H
 
 
+#include <QString>
+#include <QByteArray>
+
 #define FORBIDDEN_URL "forbidden://localhost/"
 
 void fontInitialize(int argc, char *argv[]);
+QString detectEncoding( const QByteArray &content );
 
 
 #endif /* UTILS_H */
@@ -0,0 +1,276 @@
+/*
+ * Copyright (C) 2010, 2011, 2012 by Sergey Urbanovich
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <stdio.h>
+
+#include "warcreader.h"
+
+#define CHUNK (256 * 1024)
+
+typedef QHash<QByteArray, QByteArray> Headers;
+
+
+/* parses "Name: value" lines up to the first empty line, returns offset after it */
+static int parseHeaders( const QByteArray &block, int from, Headers &headers, QByteArray *first = NULL )
+{
+	int end = block.indexOf("\r\n\r\n", from);
+	if ( end < 0 )
+		return -1;
+
+	QList<QByteArray> lines = block.mid(from, end - from).split('\n');
+	for ( int i = 0; i < lines.size(); ++i ) {
+		QByteArray line = lines.at(i).trimmed();
+		if ( i == 0 && first ) {
+			*first = line;
+			continue;
+		}
+		int colon = line.indexOf(':');
+		if ( colon <= 0 )
+			continue;
+		headers.insert(line.left(colon).trimmed().toLower(), line.mid(colon + 1).trimmed());
+	}
+	return end + 4;
+}
+
+
+static QByteArray dechunk( const QByteArray &body )
+{
+	QByteArray out;
+	int offset = 0;
+	while ( offset < body.size() ) {
+		int eol = body.indexOf("\r\n", offset);
+		if ( eol < 0 )
+			break;
+		QByteArray size = body.mid(offset, eol - offset);
+		int semicolon = size.indexOf(';');
+		if ( semicolon >= 0 )
+			size.truncate(semicolon);
+		bool ok;
+		int length = size.trimmed().toInt(&ok, 16);
+		if ( !ok || length == 0 )
+			break;
+		out.append(body.mid(eol + 2, length));
+		offset = eol + 2 + length + 2;
+	}
+	return out;
+}
+
+
+static Compression contentEncoding( const QByteArray &encoding )
+{
+	QByteArray name = encoding.toLower();
+	if ( name == "gzip" || name == "x-gzip" || name == "deflate" )
+		return CM_GZIP;
+	else if ( name == "br" )
+		return CM_BROTLI;
+	else if ( name == "zstd" )
+		return CM_ZSTD;
+	return CM_NONE;
+}
+
+
+WarcReader::WarcReader( const QString &filename )
+	: file(filename), data(NULL), size(0), compression(CM_NONE) {}
+
+
+WarcReader::~WarcReader()
+{
+	if ( data )
+		file.unmap((uchar *) data);
+}
+
+
+bool WarcReader::open()
+{
+	if ( !file.open(QFile::ReadOnly) ) {
+		qWarning() << "Couldn't open WARC file" << file.fileName();
+		return false;
+	}
+	size = file.size();
+	if ( !(data = (const char *) file.map(0, size)) ) {
+		qWarning() << "Couldn't map WARC file" << file.fileName();
+		return false;
+	}
+	compression = detectCompression(QByteArray::fromRawData(data, qMin(size, (qint64) 4)));
+	return true;
+}
+
+
+bool WarcReader::member( qint64 offset, QByteArray &raw, qint64 &length )
+{
+	if ( compression != CM_NONE ) {
+		Decompressor decoder(compression);
+		length = 0;
+		while ( !decoder.atEnd() && offset + length < size ) {
+			int rsize = raw.size();
+			qint64 consumed = decoder.decompress(data + offset + length,
+				size - offset - length, raw, CHUNK);
+			if ( consumed < 0 || (consumed == 0 && raw.size() == rsize && !decoder.atEnd()) )
+				return false;
+			length += consumed;
+		}
+		return decoder.atEnd();
+	}
+
+	/* uncompressed records are used in place, without copying */
+	QByteArray head = QByteArray::fromRawData(data + offset, qMin(size - offset, (qint64) CHUNK));
+	Headers headers;
+	int body = parseHeaders(head, 0, headers);
+	if ( body < 0 || !headers.contains("content-length") )
+		return false;
+	qint64 end = offset + body + headers.value("content-length").toLongLong();
+	if ( end > size )
+		return false;
+	raw = QByteArray::fromRawData(data + offset, end - offset);
+
+	/* records are separated by two newlines */
+	while ( end < size && (data[end] == '\r' || data[end] == '\n') )
+		end++;
+	length = end - offset;
+	return true;
+}
+
+
+bool WarcReader::scan( QList<WarcEntry> &index )
+{
+	qint64 offset = 0;
+	while ( offset < size ) {
+		QByteArray raw;
+		qint64 length;
+		Headers headers;
+		if ( !member(offset, raw, length) || parseHeaders(raw, 0, headers) < 0 ) {
+			qWarning() << "Broken WARC record at offset" << offset;
+			return false;
+		}
+		if ( headers.value("warc-type") == "response" ) {
+			WarcEntry entry;
+			entry.offset = offset;
+			entry.length = length;
+			entry.id = headers.value("warc-record-id");
+			entry.uri = QUrl::fromEncoded(headers.value("warc-target-uri"));
+			index << entry;
+		}
+		offset += length;
+	}
+	return true;
+}
+
+
+bool WarcReader::read( const WarcEntry &entry, WarcRecord &record )
+{
+	QByteArray raw;
+	qint64 length;
+	Headers warc, http;
+	QByteArray status;
+
+	if ( entry.offset + entry.length > size || !member(entry.offset, raw, length) )
+		return false;
+	int block = parseHeaders(raw, 0, warc);
+	if ( block < 0 )
+		return false;
+	/* compressed members also hold the trailing newlines after the block */
+	bool ok;
+	int clength = warc.value("content-length").toInt(&ok);
+	QByteArray content = raw.mid(block, ok ? clength : -1);
+	int body = parseHeaders(content, 0, http, &status);
+	if ( body < 0 )
+		return false;
+
+	record.id = warc.value("warc-record-id");
+	record.uri = QUrl::fromEncoded(warc.value("warc-target-uri"));
+	/* "HTTP/1.1 200 OK" */
+	record.status = status.split(' ').value(1).toInt();
+	record.mime = http.value("content-type");
+	record.compression = contentEncoding(http.value("content-encoding"));
+	record.body = content.mid(body);
+	if ( http.value("transfer-encoding").toLower() == "chunked" )
+		record.body = dechunk(record.body);
+	return true;
+}
+
+
+/* an index is trusted only if it is complete and fits this file */
+bool WarcReader::loadIndex( const QString &filename, QList<WarcEntry> &index )
+{
+	QFile in(filename);
+	if ( !in.open(QFile::ReadOnly) )
+		return false;
+
+	QByteArray content = in.readAll();
+	if ( !content.isEmpty() && !content.endsWith('\n') ) {
+		qWarning() << "Truncated WARC index" << filename;
+		return false;
+	}
+
+	QList<WarcEntry> entries;
+	foreach (const QByteArray &line, content.split('\n')) {
+		if ( line.isEmpty() )
+			continue;
+		QList<QByteArray> fields = line.split(' ');
+		bool offset_ok = false, length_ok = false;
+		WarcEntry entry;
+		if ( fields.size() == 4 ) {
+			entry.offset = fields.at(0).toLongLong(&offset_ok);
+			entry.length = fields.at(1).toLongLong(&length_ok);
+			entry.id = fields.at(2);
+			entry.uri = QUrl::fromEncoded(fields.at(3));
+		}
+		if ( !offset_ok || !length_ok || entry.offset < 0 || entry.length <= 0 ||
+		     entry.offset + entry.length > size ) {
+			qWarning() << "WARC index" << filename << "doesn't match" << file.fileName();
+			return false;
+		}
+		entries << entry;
+	}
+	index = entries;
+	return true;
+}
+
+
+/* written aside and renamed, so concurrent workers never read half an index */
+bool WarcReader::saveIndex( const QString &filename, const QList<WarcEntry> &index )
+{
+	QString temp = QString("%1.%2").arg(filename).arg(QCoreApplication::applicationPid());
+	QFile file(temp);
+	if ( !file.open(QFile::WriteOnly | QFile::Truncate) ) {
+		qWarning() << "Couldn't write WARC index" << filename;
+		return false;
+	}
+
+	/* offset length record-id target-uri */
+	QTextStream out(&file);
+	foreach (const WarcEntry &entry, index) {
+		out << entry.offset << ' ' << entry.length << ' ' << entry.id << ' '
+		    << entry.uri.toEncoded() << '\n';
+	}
+	out.flush();
+	file.close();
+
+	if ( file.error() != QFile::NoError ||
+	     ::rename(QFile::encodeName(temp).constData(), QFile::encodeName(filename).constData()) != 0 ) {
+		qWarning() << "Couldn't write WARC index" << filename;
+		file.remove();
+		return false;
+	}
+	return true;
+}
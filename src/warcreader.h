@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2010, 2011, 2012 by Sergey Urbanovich
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef WARCREADER_H
+#define WARCREADER_H
+
+
+#include <QtCore>
+#include "decompressor.h"
+
+/* position of a response record, one line of the index file */
+struct WarcEntry
+{
+	qint64 offset;
+	qint64 length;
+	QString id;
+	QUrl uri;
+};
+
+struct WarcRecord
+{
+	QString id;
+	QUrl uri;
+	int status;
+	QString mime;
+	Compression compression;
+	QByteArray body;
+};
+
+/*
+ * Reads WARC, WARC.gz and WARC.zst files. Compressed files must hold one
+ * record per gzip member or zstd frame, as the WARC specification asks,
+ * so every record can be reached directly by its offset.
+ */
+class WarcReader
+{
+public:
+	WarcReader( const QString &filename );
+	~WarcReader();
+
+	bool open();
+	bool scan( QList<WarcEntry> &index );
+	bool read( const WarcEntry &entry, WarcRecord &record );
+
+	bool loadIndex( const QString &filename, QList<WarcEntry> &index );
+	static bool saveIndex( const QString &filename, const QList<WarcEntry> &index );
+
+private:
+	bool member( qint64 offset, QByteArray &raw, qint64 &length );
+
+	QFile file;
+	const char *data;
+	qint64 size;
+	Compression compression;
+};
+
+
+#endif /* WARCREADER_H */
@@ -24,21 +24,105 @@
 #include "webpage.h"
 #include "utils.h"
 #include "networkaccessmanager.h"
+#include "jshelper.h"
+#include "serializer.h"
+#include "extractor.h"
+#include "trace.h"
 #include <QApplication>
 #include <QPrinter>
 
 #define SELECTOR "br,div,h1,h2,h3,h4,h5,h6,li,p,pre,td,tr,span,tr,ul"
 
 
-WebPage::WebPage( QList<PJsGoal> &js ) : jsC(js)
+WebPage::WebPage( QList<PJsGoal> &js, ValueFormat format, int text_clean )
+	: jsC(js), format(format), text_clean(text_clean), deduplicator(NULL),
+	  dedup_flag(false), collect_links(false), processing(false)
 {
 	QObject::connect(this, SIGNAL(loadFinished(bool)), SLOT(onLoadFinished(bool)));
+	QObject::connect(this, SIGNAL(frameCreated(QWebFrame*)), SLOT(onFrameCreated(QWebFrame*)));
+	onFrameCreated(mainFrame());
 }
 
 
 WebPage::~WebPage() {}
 
 
+/* drops near-duplicate documents of a batch, or marks their records with flag */
+void WebPage::setDeduplicator( Deduplicator *deduplicator, bool flag )
+{
+	this->deduplicator = deduplicator;
+	dedup_flag = flag;
+}
+
+
+/* links are taken before the goals run, goals may rewrite the document */
+void WebPage::setCollectLinks( bool collect )
+{
+	collect_links = collect;
+}
+
+
+const QStringList &WebPage::links() const
+{
+	return document_links;
+}
+
+
+/* fixed viewport and no scrollbars: appearing scrollbars relayout the page */
+void WebPage::setViewport( QWebPage *page, const QSize &size )
+{
+	page->setViewportSize(size);
+	page->setPreferredContentsSize(size);
+	page->mainFrame()->setScrollBarPolicy(Qt::Vertical, Qt::ScrollBarAlwaysOff);
+	page->mainFrame()->setScrollBarPolicy(Qt::Horizontal, Qt::ScrollBarAlwaysOff);
+}
+
+
+/* --text-only: features and font sizes for goals that never paint */
+void WebPage::setTextOnly( QWebSettings *settings )
+{
+	settings->setAttribute(QWebSettings::PluginsEnabled, false);
+	settings->setAttribute(QWebSettings::JavaEnabled, false);
+	settings->setAttribute(QWebSettings::AcceleratedCompositingEnabled, false);
+	settings->setAttribute(QWebSettings::TiledBackingStoreEnabled, false);
+	settings->setAttribute(QWebSettings::WebGLEnabled, false);
+	settings->setAttribute(QWebSettings::DnsPrefetchEnabled, false);
+	settings->setFontSize(QWebSettings::MinimumFontSize, 1);
+	settings->setFontSize(QWebSettings::MinimumLogicalFontSize, 1);
+	settings->setFontSize(QWebSettings::DefaultFontSize, 8);
+	settings->setFontSize(QWebSettings::DefaultFixedFontSize, 8);
+}
+
+
+/* key is the id of the output record, it tells documents of a batch apart */
+void WebPage::load( const QUrl &url, const QString &key )
+{
+	this->key = key;
+	processing = false;
+	document_links.clear();
+	/* goals of the previous document enabled javascript for this page */
+	settings()->resetAttribute(QWebSettings::JavascriptEnabled);
+	traceAsyncBegin("load", this);
+	mainFrame()->setUrl(url);
+}
+
+
+void WebPage::onFrameCreated( QWebFrame *frame )
+{
+	if ( frame->findChild<JsHelper *>() )
+		return;
+	new JsHelper(frame);
+	QObject::connect(frame, SIGNAL(javaScriptWindowObjectCleared()), SLOT(onJavaScriptWindowObjectCleared()));
+}
+
+
+void WebPage::onJavaScriptWindowObjectCleared()
+{
+	QWebFrame *frame = (QWebFrame *) sender();
+	frame->addToJavaScriptWindowObject(JSHELPER_NAME, frame->findChild<JsHelper *>());
+}
+
+
 QString WebPage::userAgentForUrl( const QUrl & url ) const
 {
 	return QWebPage::userAgentForUrl(url) + QString(" sketch/0.1");
@@ -101,31 +185,72 @@ bool WebPage::extension ( Extension, const ExtensionOption * option, ExtensionRe
 }
 
 
-void WebPage::onLoadFinished( bool success ) const
+/* text with U+2063 around block elements, so blocks don't run together */
+QString WebPage::plainText( QWebFrame *frame )
+{
+	QWebElementCollection collection = frame->findAllElements(SELECTOR);
+	foreach (QWebElement el, collection) {
+		el.prependOutside("&#x2063;");
+		el.appendOutside("&#x2063;");
+	}
+	return frame->toPlainText();
+}
+
+
+void WebPage::writeValue( QTextStream &out, const QVariant &value ) const
+{
+	TraceSpan span("write");
+	if ( format == VF_JSON && value.type() == QVariant::String ) {
+		out << value.value<QString> () << endl;
+		return;
+	}
+
+	QByteArray data;
+	serialize(value, format, data);
+	if ( format == VF_JSON )
+		data.append('\n');
+	out.flush();
+	out.device()->write(data);
+}
+
+
+void WebPage::onLoadFinished( bool success )
 {
-	static bool proccessing = false;
-	if ( proccessing )
+	if ( processing )
 		return;
 
 	if ( !success ) {
 		qWarning() << "loadFinished: any error occurred";
 		NetworkAccessManager *networkAccessManager = (NetworkAccessManager *) this->networkAccessManager();
 		if ( !networkAccessManager->isRunning() ) {
-			QApplication::exit(EXIT_FAILURE);
-			exit(EXIT_FAILURE);
+			processing = true;
+			traceAsyncEnd("load", this);
+			emit done(false);
 		}
 		return;
 	}
 
-	proccessing = true;
+	processing = true;
+	traceAsyncEnd("load", this);
+	TraceSpan span("loadFinished");
 
-	QTextStream out(stdout);
+	/* documents of a batch are framed as one record each, see webpage.h */
+	QFile file;
+	file.open(stdout, QIODevice::WriteOnly);
+	QTextStream out(&file);
 	out.setCodec("UTF-8");
+	bool framed = !key.isNull();
+	QVariantList results;
+	QString plain;
 
-	/* evaluate javascript */
-	QWebSettings::globalSettings()->setAttribute(QWebSettings::JavascriptEnabled, true);
 	QWebFrame *frame = this->mainFrame();
+	if ( collect_links )
+		document_links = extractLinks(frame, frame->url());
+
+	/* evaluate javascript */
 	foreach (const PJsGoal &js, jsC) {
+		TraceSpan goalSpan("goal");
+		goalSpan.setArg("goal", js.second);
 		if ( js.second == JSPRINT ) {
 			QPrinter printer;
 			printer.setOutputFormat(QPrinter::PdfFormat);
@@ -133,7 +258,22 @@ void WebPage::onLoadFinished( bool success ) const
 			frame->print(&printer);
 			continue;
 		}
+		/* native goals, don't need javascript */
+		if ( js.second == JSMETA || js.second == JSSELECT ) {
+			NetworkAccessManager *networkAccessManager = (NetworkAccessManager *) this->networkAccessManager();
+			QVariant value = js.second == JSMETA ?
+				extractMetadata(frame, networkAccessManager->baseUrl()) :
+				extractSelected(frame, js.first);
+			if ( framed )
+				results << value;
+			else
+				writeValue(out, value);
+			continue;
+		}
+		settings()->setAttribute(QWebSettings::JavascriptEnabled, true);
+		TraceSpan evaluateSpan("evaluateJavaScript");
 		QVariant result = frame->evaluateJavaScript(js.first);
+		evaluateSpan.end();
 		if ( js.second == JSNONE )
 			continue;
 		if ( result.type() == QVariant::Invalid ) {
@@ -144,37 +284,80 @@ void WebPage::onLoadFinished( bool success ) const
 			case JSNONE:
 				break;
 			case JSVALUE:
-				if ( result.type() == QVariant::String ) {
-					out << result.value<QString> () << endl;
-				} else {
-					QObject jvalue;
-					jvalue.setProperty("v", result);
-					frame->addToJavaScriptWindowObject("jvalue", &jvalue);
-					result = frame->evaluateJavaScript("JSON.stringify(jvalue.v);");
-					if ( result.type() == QVariant::Invalid ) {
-						qWarning() << "evaluateJavaScript: bad value";
-					} else {
-						out << result.value<QString> () << endl;
-					}
-				}
+				if ( framed )
+					results << result;
+				else
+					writeValue(out, result);
 				break;
 			case JSTEXT: {
-				QWebElementCollection collection = frame->findAllElements(SELECTOR);
-				foreach (QWebElement el, collection) {
-					el.prependOutside("&#x2063;");
-					el.appendOutside("&#x2063;");
+				QString text = plainText(frame);
+				if ( plain.isNull() )
+					plain = text;
+				if ( text_clean ) {
+					TraceSpan cleanSpan("cleanText");
+					QByteArray clean = cleanText(text, text_clean);
+					cleanSpan.end();
+					if ( framed ) {
+						results << QString::fromUtf8(clean);
+						break;
+					}
+					TraceSpan writeSpan("write");
+					clean.append('\n');
+					out.flush();
+					out.device()->write(clean);
+					break;
+				}
+				if ( framed ) {
+					results << text;
+					break;
 				}
-				out << frame->toPlainText() << endl;
+				TraceSpan writeSpan("write");
+				out << text << endl;
 				break;
 			}
-			case JSHTML:
-				out << frame->toHtml() << endl;
+			case JSHTML: {
+				QString html = frame->toHtml();
+				if ( framed ) {
+					results << html;
+					break;
+				}
+				TraceSpan writeSpan("write");
+				out << html << endl;
 				break;
+			}
 			default:
 				break;
 		}
 	}
 
-	QApplication::exit();
-	exit(EXIT_SUCCESS);
+	/* a record is complete, or dropped as a whole as a near-duplicate */
+	if ( framed ) {
+		if ( deduplicator && plain.isNull() )
+			plain = frame->toPlainText();
+		bool duplicate = deduplicator && isDuplicate(plain);
+		if ( !duplicate || dedup_flag ) {
+			QVariantMap record;
+			record.insert("id", key);
+			record.insert("results", results);
+			if ( duplicate )
+				record.insert("near_duplicate", true);
+			writeValue(out, record);
+		}
+	}
+	out.flush();
+
+	span.end();
+	emit done(true);
+}
+
+
+bool WebPage::isDuplicate( const QString &text ) const
+{
+	TraceSpan span("deduplicate");
+	if ( !deduplicator->isDuplicate(Deduplicator::fingerprint(text)) )
+		return false;
+
+	QString name = key.isNull() ? mainFrame()->url().toString() : key;
+	qWarning() << qPrintable("near-duplicate: " + name);
+	return true;
 }
@@ -27,17 +27,40 @@
 
 #include <QtWebKit>
 #include <QObject>
+#include "serializer.h"
+#include "textcleaner.h"
+#include "deduplicator.h"
 
-enum JsGoal { JSUNDEF, JSVALUE, JSHTML, JSTEXT, JSNONE, JSPRINT };
+enum JsGoal { JSUNDEF, JSVALUE, JSHTML, JSTEXT, JSNONE, JSPRINT, JSMETA, JSSELECT };
 
 typedef QPair<QString, JsGoal> PJsGoal;
 
+/* --text-only: nothing is painted, layout only has to be good enough for text */
+#define TEXT_ONLY_VIEWPORT QSize(800, 600)
+
+/*
+ * Documents loaded with a key, WARC records and crawled pages, are written
+ * as one record each with the --value-format serializer. In JSON that is
+ * one object per line:
+ *   {"id": "<key>", "results": [...]}
+ * results holds one value per goal, in order: values as returned, text
+ * and html as strings. none and print goals add nothing. With
+ * --dedup-mode flag a near-duplicate record also has "near_duplicate": true.
+ * Without a key the goals are written as before, one after another.
+ */
 class WebPage : public QWebPage
 {
 	Q_OBJECT
 	public:
-		WebPage( QList<PJsGoal> &js );
+		WebPage( QList<PJsGoal> &js, ValueFormat format = VF_JSON, int text_clean = TC_NONE );
 		~WebPage();
+		void load( const QUrl &url, const QString &key = QString() );
+		void setDeduplicator( Deduplicator *deduplicator, bool flag );
+		void setCollectLinks( bool collect );
+		const QStringList &links() const;
+		static QString plainText( QWebFrame *frame );
+		static void setTextOnly( QWebSettings *settings );
+		static void setViewport( QWebPage *page, const QSize &size );
 
 	protected:
 		virtual QString userAgentForUrl( const QUrl & url ) const;
@@ -50,11 +73,27 @@ class WebPage : public QWebPage
 		virtual bool supportsExtension( Extension extension ) const;
 		virtual bool extension ( Extension, const ExtensionOption * option, ExtensionReturn * );
 
+	signals:
+		void done( bool success );
+
 	public slots:
-		void onLoadFinished( bool success ) const;
+		void onLoadFinished( bool success );
+		void onFrameCreated( QWebFrame *frame );
+		void onJavaScriptWindowObjectCleared();
 
 	private:
+		void writeValue( QTextStream &out, const QVariant &value ) const;
+		bool isDuplicate( const QString &text ) const;
+
 		QList<PJsGoal> jsC;
+		ValueFormat format;
+		int text_clean;
+		Deduplicator *deduplicator;
+		bool dedup_flag;
+		bool collect_links;
+		QStringList document_links;
+		QString key;
+		bool processing;
 };
 
 
@@ -0,0 +1,326 @@
+/*
+ * Copyright (C) 2010, 2011, 2012 by Sergey Urbanovich
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <QApplication>
+#include <QPointer>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <stdio.h>
+
+#include "crawler.h"
+#include "networkaccessmanager.h"
+
+/* the synthetic site: "/" and a binary tree of pages /p/N, N < PAGES */
+#define PAGES   64
+#define TIMEOUT 60000
+
+
+struct Hit
+{
+	QByteArray path;
+	QByteArray host;
+	qint64 time;
+};
+
+
+/*
+ * Local HTTP stand-in. Every response is held back for "latency" ms, so
+ * requests of concurrent pages overlap and can be counted.
+ */
+class Site : public QTcpServer
+{
+	Q_OBJECT
+public:
+	Site( int latency ) : running(0), max_running(0), latency(latency)
+	{
+		connect(this, SIGNAL(newConnection()), SLOT(onNewConnection()));
+		listen(QHostAddress::LocalHost);
+		clock.start();
+	}
+
+	QString root() const
+	{
+		return QString("http://127.0.0.1:%1/").arg(serverPort());
+	}
+
+	QList<Hit> hits;
+	int running;
+	int max_running;
+
+private slots:
+	void onNewConnection()
+	{
+		while ( hasPendingConnections() ) {
+			QTcpSocket *socket = nextPendingConnection();
+			connect(socket, SIGNAL(readyRead()), SLOT(onReadyRead()));
+			connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+		}
+	}
+
+	void onReadyRead()
+	{
+		QTcpSocket *socket = (QTcpSocket *) sender();
+		QByteArray &request = requests[socket];
+		request += socket->readAll();
+		if ( !request.contains("\r\n\r\n") )
+			return;
+
+		/* "GET /path HTTP/1.1", "Host: 127.0.0.1:port" */
+		Hit hit;
+		QList<QByteArray> lines = request.split('\n');
+		hit.path = lines.at(0).split(' ').value(1);
+		foreach (const QByteArray &line, lines)
+			if ( line.toLower().startsWith("host:") )
+				hit.host = line.mid(5).trimmed();
+		hit.time = clock.elapsed();
+		hits << hit;
+		requests.remove(socket);
+
+		running++;
+		max_running = qMax(max_running, running);
+		pending << qMakePair(QPointer<QTcpSocket>(socket), hit.path);
+		QTimer::singleShot(latency, this, SLOT(respond()));
+	}
+
+	/* timers of equal latency fire in the order they were started */
+	void respond()
+	{
+		QPair<QPointer<QTcpSocket>, QByteArray> next = pending.takeFirst();
+		running--;
+		if ( !next.first )
+			return;
+		QByteArray body = page(next.second);
+		QByteArray response = QString("HTTP/1.0 200 OK\r\n"
+			"Content-Type: text/html; charset=utf-8\r\n"
+			"Content-Length: %1\r\n"
+			"Connection: close\r\n\r\n").arg(body.size()).toAscii();
+		next.first->write(response + body);
+		next.first->disconnectFromHost();
+	}
+
+private:
+	QByteArray page( const QByteArray &path ) const
+	{
+		QStringList links;
+		if ( path == "/" ) {
+			/* a duplicate, a fragment, another host and a path outside "/p/" */
+			links << "/p/1" << "/p/2" << "/p/1#top" << "/p/2"
+			      << QString("http://localhost:%1/p/9").arg(serverPort()) << "/private/x";
+		} else if ( path.startsWith("/p/") ) {
+			int n = path.mid(3).toInt();
+			if ( 2 * n + 2 < PAGES )
+				links << QString("/p/%1").arg(2 * n + 1) << QString("/p/%1").arg(2 * n + 2);
+			links << "/" << QString("/private/%1").arg(n) << QString("/p/%1#self").arg(n);
+		} else {
+			links << "/";
+		}
+
+		QString html("<html><head><title>page</title></head><body>");
+		foreach (const QString &link, links)
+			html += QString("<a href=\"%1\">%1</a> ").arg(link);
+		html += "</body></html>";
+		return html.toUtf8();
+	}
+
+	QHash<QTcpSocket *, QByteArray> requests;
+	QList<QPair<QPointer<QTcpSocket>, QByteArray> > pending;
+	QElapsedTimer clock;
+	int latency;
+};
+
+
+class CrawlWaiter : public QObject
+{
+	Q_OBJECT
+public:
+	CrawlWaiter( Crawler *crawler ) : failures(-1)
+	{
+		connect(crawler, SIGNAL(finished(int)), SLOT(onFinished(int)));
+		QTimer::singleShot(TIMEOUT, &loop, SLOT(quit()));
+	}
+	/* returns the crawl failures, or -1 on timeout */
+	int wait()
+	{
+		loop.exec();
+		return failures;
+	}
+public slots:
+	void onFinished( int crawl_failures )
+	{
+		failures = crawl_failures;
+		loop.quit();
+	}
+private:
+	QEventLoop loop;
+	int failures;
+};
+
+
+static int failed = 0;
+
+static void check( bool ok, const char *name, const QString &what )
+{
+	fprintf(stderr, "%-5s %-12s %s\n", ok ? "ok" : "FAIL", name, qPrintable(what));
+	if ( !ok )
+		failed++;
+}
+
+
+static int crawl( Site &site, int depth, int delay, int concurrency,
+                  const QStringList &prefixes = QStringList(), QList<PJsGoal> js = QList<PJsGoal>() )
+{
+	QList<WebPage *> pages;
+	for ( int i = 0; i < concurrency; ++i ) {
+		WebPage *page = new WebPage(js);
+		NetworkAccessManager *manager = new NetworkAccessManager(QUrl(), AA_NONE);
+		manager->setParent(page);
+		page->setNetworkAccessManager(manager);
+		pages << page;
+	}
+
+	Crawler crawler(pages, depth, delay, prefixes);
+	CrawlWaiter waiter(&crawler);
+	crawler.add(QUrl(site.root()));
+	crawler.start();
+	return waiter.wait();
+}
+
+
+static QStringList paths( const Site &site )
+{
+	QStringList list;
+	foreach (const Hit &hit, site.hits)
+		list << hit.path;
+	qSort(list);
+	return list;
+}
+
+
+static QStringList expected( const char *list )
+{
+	QStringList want = QString(list).split(' ');
+	qSort(want);
+	return want;
+}
+
+
+/* depth limit, host filtering and deduplication */
+static void testDepth()
+{
+	Site site(20);
+	int failures = crawl(site, 2, 0, 3);
+	check(failures == 0, "depth", QString("crawl finished, failures %1").arg(failures));
+
+	QStringList want = expected("/ /p/1 /p/2 /p/3 /p/4 /p/5 /p/6 /private/x /private/1 /private/2");
+	check(paths(site) == want, "depth",
+	      QString("requested %1, expected %2").arg(paths(site).join(" ")).arg(want.join(" ")));
+
+	bool local = true;
+	foreach (const Hit &hit, site.hits)
+		local = local && hit.host.startsWith("127.0.0.1");
+	check(local, "depth", "no request left the seed host");
+}
+
+
+/* --crawl-prefix */
+static void testPrefix()
+{
+	Site site(20);
+	int failures = crawl(site, 2, 0, 3, QStringList() << site.root() + "p/");
+	check(failures == 0, "prefix", QString("crawl finished, failures %1").arg(failures));
+
+	QStringList want = expected("/ /p/1 /p/2 /p/3 /p/4 /p/5 /p/6");
+	check(paths(site) == want, "prefix",
+	      QString("requested %1, expected %2").arg(paths(site).join(" ")).arg(want.join(" ")));
+}
+
+
+/* goals that rewrite the document, like readability, don't cut the frontier */
+static void testGoals()
+{
+	QList<PJsGoal> js;
+	js << PJsGoal("true", JSTEXT);
+	js << PJsGoal("document.body.innerHTML = '<p>article</p>';", JSNONE);
+
+	Site site(20);
+	int failures = crawl(site, 2, 0, 3, QStringList(), js);
+	check(failures == 0, "goals", QString("crawl finished, failures %1").arg(failures));
+
+	QStringList want = expected("/ /p/1 /p/2 /p/3 /p/4 /p/5 /p/6 /private/x /private/1 /private/2");
+	check(paths(site) == want, "goals",
+	      QString("requested %1, expected %2").arg(paths(site).join(" ")).arg(want.join(" ")));
+}
+
+
+/* --crawl-concurrency on a single host, without a delay */
+static void testConcurrency()
+{
+	Site site(200);
+	int failures = crawl(site, 3, 0, 4);
+	check(failures == 0, "concurrency", QString("crawl finished, failures %1").arg(failures));
+	check(site.max_running > 1, "concurrency",
+	      QString("%1 requests in flight at most").arg(site.max_running));
+}
+
+
+/* --crawl-delay: starts on one host are spaced, but still overlap */
+static void testDelay()
+{
+	const int delay = 100;
+	Site site(300);
+	int failures = crawl(site, 2, delay, 4);
+	check(failures == 0, "delay", QString("crawl finished, failures %1").arg(failures));
+
+	/* arrivals jitter a bit around the crawler's own clock */
+	qint64 gap = -1;
+	for ( int i = 1; i < site.hits.size(); ++i ) {
+		qint64 diff = site.hits.at(i).time - site.hits.at(i - 1).time;
+		if ( gap < 0 || diff < gap )
+			gap = diff;
+	}
+	check(gap >= delay * 3 / 4, "delay", QString("shortest gap between requests %1 ms").arg(gap));
+	check(site.max_running > 1, "delay",
+	      QString("%1 requests in flight at most").arg(site.max_running));
+}
+
+
+int main( int argc, char *argv[] )
+{
+#ifdef Q_WS_QPA
+	setenv("QT_QPA_PLATFORM", "minimal", 0);
+#endif /* Q_WS_QPA */
+
+	QApplication::setGraphicsSystem("raster");
+	QApplication app(argc, argv);
+	QWebSettings::globalSettings()->setAttribute(QWebSettings::AutoLoadImages, false);
+
+	/* pages print their records on stdout, results go to stderr */
+	testDepth();
+	testPrefix();
+	testGoals();
+	testConcurrency();
+	testDelay();
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+#include "crawltest.moc"
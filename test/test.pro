@@ -0,0 +1,11 @@
+# Crawl test against a local HTTP stand-in serving a synthetic site:
+#   cd test && qmake && make && ./sketch-test
+
+QT      += webkit network
+TARGET   = sketch-test
+include(../src/src.pri)
+SOURCES += crawltest.cpp
+
+# objects stay next to this file, not in the top directory of sketch
+MOC_DIR = $$PWD
+OBJECTS_DIR = $$PWD